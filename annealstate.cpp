@@ -0,0 +1,278 @@
+#include "annealstate.h"
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace {
+
+// Shape candidates inspected per direction: random members of each size
+// bucket, and a window of the destination day's inverse preference list.
+constexpr int kBucketSamples = 4;
+constexpr int kPreferringWindow = 32;
+
+} // namespace
+
+AnnealState::AnnealState(const ProblemData* data, const CostModel* cost)
+    : m_data(data), m_cost(cost)
+{
+    std::vector<char> present(ProblemData::kMaxFamilySize + 1, 0);
+    for (uint8_t n : m_data->familySizes()) {
+        present[n] = 1;
+        m_maxSize = std::max(m_maxSize, (int)n);
+    }
+    for (int n = 0; n <= m_maxSize; ++n)
+        if (present[n]) m_sizes.push_back(n);
+}
+
+void AnnealState::reset(const std::vector<int>& assignment)
+{
+    const int F = m_data->familyCount();
+    m_assign = assignment;
+    m_occ.assign(101, 0);
+    m_buckets.assign(bucket(101, 0), {});
+    m_posInBucket.assign(F, 0);
+
+    for (int i = 0; i < F; ++i) {
+        const int d = m_assign[i];
+        m_occ[d] += m_data->familySize(i);
+        addToDay(i, d);
+    }
+    resync();
+}
+
+void AnnealState::resync()
+{
+    const int F = m_data->familyCount();
+    m_pref = 0;
+    for (int i = 0; i < F; ++i)
+        m_pref += (int64_t)m_cost->preferenceCost(i, m_assign[i]);
+    m_accounting.reset(m_occ);
+    m_hash = m_zobrist ? m_zobrist->hash(m_assign) : 0;
+    m_violation = 0;
+    for (int d = 1; d <= 100; ++d)
+        m_violation += CostModel::capacityViolation(m_occ[d]);
+}
+
+void AnnealState::setOscillation(bool enabled, double penaltyWeight)
+{
+    m_oscillation = enabled;
+    m_penaltyWeight = penaltyWeight;
+}
+
+void AnnealState::setZobrist(const ZobristTable* zobrist)
+{
+    m_zobrist = zobrist;
+    m_hash = (m_zobrist && !m_assign.empty()) ? m_zobrist->hash(m_assign) : 0;
+}
+
+uint64_t AnnealState::hashAfter(const Proposal& p) const
+{
+    if (!m_zobrist) return 0;
+    uint64_t h = m_hash ^ m_zobrist->key(p.f1, m_assign[p.f1]) ^ m_zobrist->key(p.f1, p.day1);
+    if (p.f2 >= 0)
+        h ^= m_zobrist->key(p.f2, m_assign[p.f2]) ^ m_zobrist->key(p.f2, p.day2);
+    return h;
+}
+
+bool AnnealState::proposeMove(int f, int newDay, Proposal& out) const
+{
+    const int oldDay = m_assign[f];
+    if (newDay == oldDay) return false;
+
+    const int n = m_data->familySize(f);
+    if (!m_oscillation) {
+        if (m_occ[oldDay] - n < 125) return false;
+        if (m_occ[newDay] + n > 300) return false;
+    }
+
+    out.f1 = f;
+    out.day1 = newDay;
+    out.f2 = -1;
+    out.dPref =
+        (int64_t)m_cost->preferenceCost(f, newDay) -
+        (int64_t)m_cost->preferenceCost(f, oldDay);
+
+    const double dAcc = m_accounting.delta(m_occ, oldDay, -n, newDay, +n, &out.terms);
+    out.delta = (double)out.dPref + dAcc;
+    out.dViolation = 0;
+    if (m_oscillation) {
+        out.dViolation = CostModel::deltaViolation2(m_occ, oldDay, -n, newDay, +n);
+        out.delta += m_penaltyWeight * (double)out.dViolation;
+    }
+    return true;
+}
+
+bool AnnealState::proposeSwap(int f1, int f2, Proposal& out) const
+{
+    if (f1 == f2) return false;
+
+    const int d1 = m_assign[f1];
+    const int d2 = m_assign[f2];
+    if (d1 == d2) return false;
+
+    const int n1 = m_data->familySize(f1);
+    const int n2 = m_data->familySize(f2);
+
+    const int newOcc1 = m_occ[d1] - n1 + n2;
+    const int newOcc2 = m_occ[d2] - n2 + n1;
+
+    if (!m_oscillation) {
+        if (newOcc1 < 125 || newOcc1 > 300) return false;
+        if (newOcc2 < 125 || newOcc2 > 300) return false;
+    }
+
+    out.f1 = f1;
+    out.day1 = d2;
+    out.f2 = f2;
+    out.day2 = d1;
+    out.dPref =
+        (int64_t)m_cost->preferenceCost(f1, d2) +
+        (int64_t)m_cost->preferenceCost(f2, d1) -
+        (int64_t)m_cost->preferenceCost(f1, d1) -
+        (int64_t)m_cost->preferenceCost(f2, d2);
+
+    const double dAcc =
+        m_accounting.delta(m_occ, d1, (-n1 + n2), d2, (-n2 + n1), &out.terms);
+    out.delta = (double)out.dPref + dAcc;
+    out.dViolation = 0;
+    if (m_oscillation) {
+        out.dViolation = CostModel::deltaViolation2(m_occ, d1, (-n1 + n2), d2, (-n2 + n1));
+        out.delta += m_penaltyWeight * (double)out.dViolation;
+    }
+    return true;
+}
+
+bool AnnealState::proposeShape(int dayA, int dayB, std::mt19937& rng, Proposal& out) const
+{
+    if (dayA == dayB) return false;
+
+    // Cheapest family per size for each direction (0: A -> B, 1: B -> A).
+    constexpr int kSlots = ProblemData::kMaxFamilySize + 1;
+    std::array<int64_t, kSlots> bestPref[2];
+    std::array<int, kSlots> bestFam[2];
+    for (int dir = 0; dir < 2; ++dir)
+        for (int n : m_sizes) {
+            bestPref[dir][n] = std::numeric_limits<int64_t>::max();
+            bestFam[dir][n] = -1;
+        }
+
+    for (int dir = 0; dir < 2; ++dir) {
+        const int src = dir == 0 ? dayA : dayB;
+        const int dst = dir == 0 ? dayB : dayA;
+        auto consider = [&](int f) {
+            const int n = m_data->familySize(f);
+            const int64_t dPref = (int64_t)m_cost->preferenceCost(f, dst) - (int64_t)m_cost->preferenceCost(f, src);
+            if (dPref < bestPref[dir][n]) {
+                bestPref[dir][n] = dPref;
+                bestFam[dir][n] = f;
+            }
+        };
+
+        const std::vector<int>& preferring = m_cost->familiesPreferring(dst);
+        if (!preferring.empty()) {
+            const int count = std::min<int>(kPreferringWindow, (int)preferring.size());
+            const int start = std::uniform_int_distribution<int>(0, (int)preferring.size() - 1)(rng);
+            for (int k = 0; k < count; ++k) {
+                const int f = preferring[(size_t)((start + k) % (int)preferring.size())];
+                if (m_assign[f] == src) consider(f);
+            }
+        }
+        for (int n : m_sizes) {
+            const std::vector<int>& members = m_buckets[bucket(src, n)];
+            if (members.empty()) continue;
+            std::uniform_int_distribution<int> pick(0, (int)members.size() - 1);
+            for (int k = 0; k < kBucketSamples; ++k) consider(members[(size_t)pick(rng)]);
+        }
+    }
+
+    // The accounting and violation deltas only depend on the net number of
+    // people t moved from A to B, so each t is evaluated once.
+    std::array<double, 2 * kSlots> accByNet;
+    std::array<bool, 2 * kSlots> known{};
+    auto netDelta = [&](int t) {
+        double& acc = accByNet[(size_t)(t + kSlots)];
+        if (!known[(size_t)(t + kSlots)]) {
+            known[(size_t)(t + kSlots)] = true;
+            acc = m_accounting.delta(m_occ, dayA, -t, dayB, +t);
+            if (m_oscillation)
+                acc += m_penaltyWeight * (double)CostModel::deltaViolation2(m_occ, dayA, -t, dayB, +t);
+        }
+        return acc;
+    };
+    auto allowed = [&](int t) {
+        if (m_oscillation) return true;
+        const int a = m_occ[dayA] - t;
+        const int b = m_occ[dayB] + t;
+        return a >= 125 && a <= 300 && b >= 125 && b <= 300;
+    };
+
+    double best = std::numeric_limits<double>::infinity();
+    int bestF1 = -1, bestF2 = -1;
+    for (int n : m_sizes) {
+        if (bestFam[0][n] >= 0 && allowed(n)) {
+            const double d = (double)bestPref[0][n] + netDelta(n);
+            if (d < best) { best = d; bestF1 = bestFam[0][n]; bestF2 = -1; }
+        }
+        if (bestFam[1][n] >= 0 && allowed(-n)) {
+            const double d = (double)bestPref[1][n] + netDelta(-n);
+            if (d < best) { best = d; bestF1 = bestFam[1][n]; bestF2 = -1; }
+        }
+    }
+    for (int n1 : m_sizes) {
+        if (bestFam[0][n1] < 0) continue;
+        for (int n2 : m_sizes) {
+            if (n2 == n1 || bestFam[1][n2] < 0 || !allowed(n1 - n2)) continue;
+            const double d = (double)(bestPref[0][n1] + bestPref[1][n2]) + netDelta(n1 - n2);
+            if (d < best) { best = d; bestF1 = bestFam[0][n1]; bestF2 = bestFam[1][n2]; }
+        }
+    }
+
+    if (bestF1 < 0) return false;
+    if (bestF2 >= 0) return proposeSwap(bestF1, bestF2, out);
+    return proposeMove(bestF1, m_assign[bestF1] == dayA ? dayB : dayA, out);
+}
+
+void AnnealState::commit(const Proposal& p)
+{
+    if (m_zobrist) m_hash = hashAfter(p);
+
+    const int from1 = m_assign[p.f1];
+    const int n1 = m_data->familySize(p.f1);
+    removeFromDay(p.f1, from1);
+    m_occ[from1] -= n1;
+
+    if (p.f2 >= 0) {
+        const int from2 = m_assign[p.f2];
+        const int n2 = m_data->familySize(p.f2);
+        removeFromDay(p.f2, from2);
+        m_occ[from2] -= n2;
+        m_assign[p.f2] = p.day2;
+        m_occ[p.day2] += n2;
+        addToDay(p.f2, p.day2);
+    }
+
+    m_assign[p.f1] = p.day1;
+    m_occ[p.day1] += n1;
+    addToDay(p.f1, p.day1);
+
+    m_pref += p.dPref;
+    m_accounting.commit(p.terms);
+    m_violation += p.dViolation;
+}
+
+void AnnealState::removeFromDay(int fam, int day)
+{
+    auto& b = m_buckets[bucket(day, m_data->familySize(fam))];
+    const int p = m_posInBucket[fam];
+    const int last = b.back();
+    b[p] = last;
+    m_posInBucket[last] = p;
+    b.pop_back();
+}
+
+void AnnealState::addToDay(int fam, int day)
+{
+    auto& b = m_buckets[bucket(day, m_data->familySize(fam))];
+    m_posInBucket[fam] = (int)b.size();
+    b.push_back(fam);
+}
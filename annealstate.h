@@ -0,0 +1,87 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <random>
+#include "problemdata.h"
+#include "costmodel.h"
+#include "zobrist.h"
+
+// A candidate change: f1 goes to day1 and, for a swap, f2 goes to day2.
+struct Proposal {
+    int f1 = -1, day1 = 0;
+    int f2 = -1, day2 = 0;
+    int64_t dPref = 0;
+    AccountingTerms terms;
+    int dViolation = 0;   // change in people outside [125, 300]
+    double delta = 0.0;   // cost delta plus any oscillation penalty
+};
+
+// Incremental search state shared by the annealer and the genetic engine:
+// assignment, occupancy, per-day family lists by size and exact cost terms. The
+// propose functions check the 125/300 bounds and fill in the cost delta;
+// commit applies an accepted proposal. In oscillation mode the bounds are
+// not enforced; people outside them are charged penaltyWeight each instead.
+class AnnealState {
+public:
+    AnnealState(const ProblemData* data, const CostModel* cost);
+
+    void reset(const std::vector<int>& assignment);
+    void resync();
+
+    // Enables incremental Zobrist hashing of the assignment (nullptr = off).
+    void setZobrist(const ZobristTable* zobrist);
+    bool hashing() const { return m_zobrist != nullptr; }
+    uint64_t hash() const { return m_hash; }
+    uint64_t hashAfter(const Proposal& p) const;
+
+    void setOscillation(bool enabled, double penaltyWeight);
+    void setPenaltyWeight(double weight) { m_penaltyWeight = weight; }
+    double penaltyWeight() const { return m_penaltyWeight; }
+    bool feasible() const { return m_violation == 0; }
+
+    const ProblemData* data() const { return m_data; }
+    const std::vector<int>& assignment() const { return m_assign; }
+    const std::vector<int>& occupancy() const { return m_occ; }
+    // Families of exactly `size` people on `day`.
+    const std::vector<int>& familiesOnDay(int day, int size) const { return m_buckets[bucket(day, size)]; }
+    const std::vector<int>& familySizes() const { return m_sizes; }
+
+    const AccountingTracker& accounting() const { return m_accounting; }
+    double cost() const { return (double)m_pref + m_accounting.total(); }
+
+    bool proposeMove(int f, int newDay, Proposal& out) const;
+    bool proposeSwap(int f1, int f2, Proposal& out) const;
+    // Occupancy shaping between two days: the best move of one family or
+    // swap of two families of different sizes between dayA and dayB, judged
+    // by preference plus accounting delta. Candidates per size come from the
+    // size buckets and from a window of the inverse preference lists, so the
+    // cost does not grow with the number of families on either day.
+    bool proposeShape(int dayA, int dayB, std::mt19937& rng, Proposal& out) const;
+    void commit(const Proposal& p);
+
+private:
+    const ProblemData* m_data = nullptr;
+    const CostModel* m_cost = nullptr;
+
+    std::vector<int> m_assign;
+    std::vector<int> m_occ;
+    // Per-(day, size) family lists; sizes 0..m_maxSize.
+    int m_maxSize = 0;
+    std::vector<int> m_sizes;              // distinct family sizes
+    std::vector<std::vector<int>> m_buckets;
+    std::vector<int> m_posInBucket;
+
+    int64_t m_pref = 0;
+    AccountingTracker m_accounting;
+
+    const ZobristTable* m_zobrist = nullptr;
+    uint64_t m_hash = 0;
+
+    bool m_oscillation = false;
+    double m_penaltyWeight = 0.0;
+    int m_violation = 0;
+
+    size_t bucket(int day, int size) const { return (size_t)day * (size_t)(m_maxSize + 1) + (size_t)size; }
+    void removeFromDay(int fam, int day);
+    void addToDay(int fam, int day);
+};
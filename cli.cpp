@@ -0,0 +1,571 @@
+#include "cli.h"
+#include "problemdata.h"
+#include "costmodel.h"
+#include "solver.h"
+#include "island.h"
+#include "regress.h"
+#include "scorer.h"
+#include "seedstream.h"
+#include "snapshotwriter.h"
+#include "tuner.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QTextStream>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace {
+
+QTextStream& err()
+{
+    static QTextStream s(stderr);
+    return s;
+}
+
+QString csvField(const QString& s)
+{
+    if (!s.contains(',') && !s.contains('"')) return s;
+    QString quoted = s;
+    quoted.replace("\"", "\"\"");
+    return "\"" + quoted + "\"";
+}
+
+bool loadData(const QString& path, ProblemData& data, std::unique_ptr<CostModel>& cost)
+{
+    QString e;
+    if (!data.loadFamilyCsv(path, &e)) {
+        err() << e << Qt::endl;
+        return false;
+    }
+    cost = std::make_unique<CostModel>(data);
+    cost->build();
+    return true;
+}
+
+void addSolverOptions(QCommandLineParser& p)
+{
+    p.addOption({ "data", "family_data.csv to solve.", "path", "family_data.csv" });
+    p.addOption({ "iterations", "Annealing iterations.", "n", "2000000" });
+    p.addOption({ "t0", "Start temperature.", "t", "10000" });
+    p.addOption({ "t1", "End temperature.", "t", "1" });
+    p.addOption({ "seed", "Random seed.", "n", "42" });
+    p.addOption({ "threads", "Worker threads for parallel phases (0 = all cores).", "n", "0" });
+    p.addOption({ "oscillation", "Allow penalized 125/300 violations." });
+    p.addOption({ "shape", "Probability of an occupancy-shaping step (0 = off).", "p", "0" });
+}
+
+SolverParams solverParamsFrom(const QCommandLineParser& p)
+{
+    SolverParams params;
+    params.maxIterations = p.value("iterations").toInt();
+    params.reportEvery = std::max(1, params.maxIterations / 100);
+    params.startTemp = p.value("t0").toDouble();
+    params.endTemp = p.value("t1").toDouble();
+    params.seed = p.value("seed").toUInt();
+    params.threads = p.value("threads").toInt();
+    params.oscillation = p.isSet("oscillation");
+    params.moves.shapeProbability = p.value("shape").toDouble();
+    return params;
+}
+
+template <typename T>
+bool parseList(const QString& text, std::vector<T>& out)
+{
+    out.clear();
+    for (const QString& part : text.split(',')) {
+        bool ok = false;
+        const double v = part.trimmed().toDouble(&ok);
+        if (!ok) return false;
+        out.push_back((T)v);
+    }
+    return !out.empty();
+}
+
+void addIslandOptions(QCommandLineParser& p)
+{
+    p.addOption({ "segment", "Shared-memory segment name.", "name", "/santa-islands" });
+    p.addOption({ "migrate-every", "Iterations between elite exchanges.", "n", "200000" });
+    p.addOption({ "policy", "Migration policy: best, ring or random.", "name", "best" });
+    p.addOption({ "snapshot-every", "Also write the best so far to --output (and a .bin) this often; 0 = only at the end.", "ms", "0" });
+}
+
+int runIsland(const QStringList& args)
+{
+    QCommandLineParser p;
+    p.setApplicationDescription("Run one annealing island that exchanges elites through shared memory.");
+    p.addHelpOption();
+    addSolverOptions(p);
+    addIslandOptions(p);
+    p.addOption({ "islands", "Number of island slots in the segment.", "n", "4" });
+    p.addOption({ "id", "Slot of this island.", "n", "0" });
+    p.addOption({ "campaign", "Campaign id (hex, nonzero, required); islands only share a segment within one campaign.", "id" });
+    p.addOption({ "reset", "Remove the segment first, e.g. one left behind by a crashed island." });
+    p.addOption({ "output", "Submission written at the end (default submission_island<id>.csv).", "path" });
+    p.process(args);
+
+    ProblemData data;
+    std::unique_ptr<CostModel> cost;
+    if (!loadData(p.value("data"), data, cost)) return 1;
+
+    const int islands = p.value("islands").toInt();
+    const int id = p.value("id").toInt();
+    if (id < 0 || id >= islands) {
+        err() << "--id must be in [0, --islands)." << Qt::endl;
+        return 2;
+    }
+
+    MigrationParams migration;
+    migration.everyIterations = p.value("migrate-every").toInt();
+    bool ok = false;
+    migration.policy = IslandExchange::policyFromString(p.value("policy"), &ok);
+    if (!ok) {
+        err() << "Unknown migration policy: " << p.value("policy") << Qt::endl;
+        return 2;
+    }
+
+    IslandExchange exchange;
+    QString e;
+    bool campaignOk = false;
+    const uint64_t campaign = p.value("campaign").toULongLong(&campaignOk, 16);
+    if (!campaignOk || campaign == 0) {
+        err() << "--campaign must be a nonzero hex number." << Qt::endl;
+        return 2;
+    }
+    if (p.isSet("reset")) IslandExchange::unlink(p.value("segment"));
+    if (!exchange.open(p.value("segment"), islands, data.familyCount(), campaign, data.checksum(), &e)) {
+        err() << e << Qt::endl;
+        return 1;
+    }
+
+    SolverParams params = solverParamsFrom(p);
+    params.seed = deriveSeed(params.seed, SeedStream::Island, (uint64_t)id);
+
+    const QString out = p.isSet("output") ? p.value("output")
+                                          : QString("submission_island%1.csv").arg(id);
+
+    SolverWorker worker(&data, cost.get(), QVector<int>(), params);
+    worker.setMigration(&exchange, id, migration);
+
+    SnapshotWriter writer(&data);
+    // Emitted on the writer thread: only record here, print after flush().
+    std::mutex failuresMutex;
+    QStringList failures;
+    QObject::connect(&writer, &SnapshotWriter::failed, [&](const QString&, const QString& msg) {
+        std::lock_guard<std::mutex> lock(failuresMutex);
+        failures << msg;
+    });
+    if (p.value("snapshot-every").toInt() > 0) {
+        SnapshotPolicy policy;
+        policy.csvPath = out;
+        policy.intervalMs = p.value("snapshot-every").toInt();
+        worker.setSnapshots(&writer, policy);
+    }
+
+    QVector<int> best;
+    double bestCost = 0.0;
+    QObject::connect(&worker, &SolverWorker::log, [id](const QString& msg) {
+        err() << "[island " << id << "] " << msg << Qt::endl;
+    });
+    QObject::connect(&worker, &SolverWorker::finished, [&](QVector<int> a, double c) {
+        best = a;
+        bestCost = c;
+    });
+    worker.run();
+
+    // Only a failed final save fails the island; periodic snapshots are
+    // drained first so their errors are not counted.
+    writer.flush();
+    const int periodicFailures = failures.size();
+    writer.submit(std::vector<int>(best.begin(), best.end()), bestCost, out, SnapshotWriter::binaryPathFor(out));
+    writer.flush();
+    for (const QString& msg : failures)
+        err() << "[island " << id << "] snapshot failed: " << msg << Qt::endl;
+    if (failures.size() > periodicFailures) return 1;
+    QTextStream(stdout) << "island " << id << " best " << QString::number(bestCost, 'f', 2)
+                        << " -> " << out << Qt::endl;
+    return 0;
+}
+
+int runIslands(const QStringList& args)
+{
+    QCommandLineParser p;
+    p.setApplicationDescription("Launch island processes on this machine and wait for all of them.");
+    p.addHelpOption();
+    addSolverOptions(p);
+    addIslandOptions(p);
+    p.addOption({ "count", "Number of island processes.", "n", "4" });
+    p.process(args);
+
+    ProblemData data;
+    std::unique_ptr<CostModel> cost;
+    if (!loadData(p.value("data"), data, cost)) return 1;
+
+    const int count = p.value("count").toInt();
+    const QString segment = p.value("segment");
+    if (count < 1) {
+        err() << "--count must be positive." << Qt::endl;
+        return 2;
+    }
+
+    // Start from a clean segment; the launcher holds it open so the geometry
+    // is fixed before any island attaches.
+    IslandExchange::unlink(segment);
+    std::random_device entropy;
+    const uint64_t campaign = (((uint64_t)entropy() << 32) ^ entropy() ^ (uint64_t)QCoreApplication::applicationPid()) | 1;
+    IslandExchange exchange;
+    QString e;
+    if (!exchange.open(segment, count, data.familyCount(), campaign, data.checksum(), &e)) {
+        err() << e << Qt::endl;
+        return 1;
+    }
+
+    QStringList common;
+    for (const char* name : { "data", "iterations", "t0", "t1", "seed", "threads",
+                              "shape", "segment", "migrate-every", "policy",
+                              "snapshot-every" })
+        common << QString("--") + name << p.value(name);
+    if (p.isSet("oscillation")) common << "--oscillation";
+    common << "--campaign" << QString::number((qulonglong)campaign, 16);
+
+    std::vector<std::unique_ptr<QProcess>> procs;
+    for (int i = 0; i < count; ++i) {
+        auto proc = std::make_unique<QProcess>();
+        proc->setProcessChannelMode(QProcess::ForwardedChannels);
+        proc->start(QCoreApplication::applicationFilePath(),
+                    QStringList{ "island", "--islands", QString::number(count), "--id", QString::number(i) } + common);
+        procs.push_back(std::move(proc));
+    }
+
+    // A crashed island only loses its own slot; the others keep running.
+    int failed = 0;
+    for (int i = 0; i < count; ++i) {
+        procs[i]->waitForFinished(-1);
+        if (procs[i]->exitStatus() != QProcess::NormalExit || procs[i]->exitCode() != 0) {
+            err() << "island " << i << " failed (exit code " << procs[i]->exitCode() << ")" << Qt::endl;
+            ++failed;
+        }
+    }
+
+    // Ties go to the lowest island id so the reported winner is stable.
+    int bestIsland = -1;
+    double bestCost = 0.0;
+    Migrant m;
+    for (int i = 0; i < count; ++i) {
+        if (!exchange.read(i, m)) continue;
+        if (bestIsland < 0 || m.cost < bestCost) {
+            bestIsland = i;
+            bestCost = m.cost;
+        }
+    }
+    exchange.close();
+
+    if (bestIsland < 0) {
+        err() << "No island published a result." << Qt::endl;
+        return 1;
+    }
+    QTextStream(stdout) << "best island " << bestIsland << " cost " << QString::number(bestCost, 'f', 2)
+                        << " (" << failed << " of " << count << " islands failed)" << Qt::endl;
+    return failed == count ? 1 : 0;
+}
+
+int runScore(const QStringList& args)
+{
+    QCommandLineParser p;
+    p.setApplicationDescription("Score submission CSVs and print a report sorted by total cost.");
+    p.addHelpOption();
+    p.addPositionalArgument("paths", "Submission files (.csv or .bin snapshots) or directories of them.", "paths...");
+    p.addOption({ "data", "family_data.csv the submissions refer to.", "path", "family_data.csv" });
+    p.addOption({ "threads", "Scoring threads (0 = all cores).", "n", "0" });
+    p.addOption({ "output", "Write the CSV report here instead of stdout.", "path" });
+    p.addOption({ "occupancy", "Add per-day occupancy columns to the report." });
+    p.process(args);
+
+    ProblemData data;
+    std::unique_ptr<CostModel> cost;
+    if (!loadData(p.value("data"), data, cost)) return 1;
+
+    const QStringList paths = SubmissionScorer::expandPaths(p.positionalArguments());
+    if (paths.isEmpty()) {
+        err() << "No submissions given." << Qt::endl;
+        return 2;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const SubmissionScorer scorer(data, *cost);
+    const std::vector<SubmissionScore> scores = scorer.scoreAll(paths, p.value("threads").toInt());
+    const qint64 ms = timer.elapsed();
+
+    QFile file;
+    if (p.isSet("output")) {
+        file.setFileName(p.value("output"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            err() << "Cannot write: " << p.value("output") << Qt::endl;
+            return 1;
+        }
+    } else if (!file.open(stdout, QIODevice::WriteOnly | QIODevice::Text)) {
+        return 1;
+    }
+
+    const bool withOccupancy = p.isSet("occupancy");
+    QTextStream out(&file);
+    out << "rank,path,valid,total,preference,accounting,min_occupancy,max_occupancy";
+    for (int r = 0; r < 10; ++r) out << ",choice_" << r;
+    out << ",no_choice";
+    if (withOccupancy)
+        for (int d = 1; d <= 100; ++d) out << ",day_" << d;
+    out << ",error\n";
+
+    int valid = 0;
+    for (size_t i = 0; i < scores.size(); ++i) {
+        const SubmissionScore& s = scores[i];
+        if (s.valid) ++valid;
+        out << (i + 1) << "," << csvField(s.path) << "," << (s.valid ? 1 : 0) << ","
+            << QString::number(s.total, 'f', 4) << "," << s.preference << ","
+            << QString::number(s.accounting, 'f', 4) << ","
+            << s.minOccupancy << "," << s.maxOccupancy;
+        for (int r = 0; r <= 10; ++r) out << "," << s.rankHistogram[r];
+        if (withOccupancy)
+            for (int d = 1; d <= 100; ++d) out << "," << s.occupancy[d];
+        out << "," << csvField(s.error) << "\n";
+    }
+    out.flush();
+
+    err() << "scored " << (int)scores.size() << " submissions (" << valid << " valid) in "
+          << ms << " ms" << Qt::endl;
+    return 0;
+}
+
+int runTune(const QStringList& args)
+{
+    QCommandLineParser p;
+    p.setApplicationDescription("Search annealing settings and report cost-vs-time results.\n"
+                                "List options take comma-separated values.");
+    p.addHelpOption();
+    p.addOption({ "data", "family_data.csv to tune on.", "path", "family_data.csv" });
+    p.addOption({ "strategy", "grid, random or halving.", "name", "grid" });
+    p.addOption({ "t0", "Start temperatures.", "list", "10000" });
+    p.addOption({ "t1", "End temperatures.", "list", "1" });
+    p.addOption({ "iterations", "Iteration counts (halving: the largest is the full budget).", "list", "2000000" });
+    p.addOption({ "swap", "Swap probabilities.", "list", "0.3" });
+    p.addOption({ "choice-move", "Probabilities that a move targets a choice day.", "list", "0.85" });
+    p.addOption({ "ranks", "Number of choice ranks moves may target.", "list", "10" });
+    p.addOption({ "shape", "Occupancy-shaping step probabilities.", "list", "0" });
+    p.addOption({ "samples", "Configurations drawn by random / halving.", "n", "32" });
+    p.addOption({ "eta", "Halving reduction factor.", "n", "3" });
+    p.addOption({ "repeats", "Seeds per configuration.", "n", "1" });
+    p.addOption({ "threads", "Concurrent runs (0 = all cores).", "n", "0" });
+    p.addOption({ "seed", "Sampling and solver seed.", "n", "42" });
+    p.addOption({ "budget", "Time budget in seconds for the recommendation (0 = none).", "s", "0" });
+    p.addOption({ "output", "Write the summary CSV here instead of stdout.", "path" });
+    p.addOption({ "curves", "Write best-cost-vs-time curves of every run here.", "path" });
+    p.addOption({ "oscillation", "Tune with strategic oscillation enabled." });
+    p.addOption({ "polish", "Polish each run's best (included in its time)." });
+    p.process(args);
+
+    TuneSpace space;
+    TuneOptions options;
+    if (!Tuner::strategyFromString(p.value("strategy"), options.strategy)) {
+        err() << "Unknown strategy: " << p.value("strategy") << Qt::endl;
+        return 2;
+    }
+    if (!parseList(p.value("t0"), space.startTemps) || !parseList(p.value("t1"), space.endTemps)
+        || !parseList(p.value("iterations"), space.iterations)
+        || !parseList(p.value("swap"), space.swapProbabilities)
+        || !parseList(p.value("choice-move"), space.choiceMoveProbabilities)
+        || !parseList(p.value("ranks"), space.choiceRanks)
+        || !parseList(p.value("shape"), space.shapeProbabilities)) {
+        err() << "Malformed value list." << Qt::endl;
+        return 2;
+    }
+    for (int r : space.choiceRanks) {
+        if (r < 1 || r > 10) {
+            err() << "--ranks values must be in 1..10." << Qt::endl;
+            return 2;
+        }
+    }
+    options.samples = p.value("samples").toInt();
+    options.eta = p.value("eta").toInt();
+    options.repeats = p.value("repeats").toInt();
+    options.threads = p.value("threads").toInt();
+    options.seed = p.value("seed").toUInt();
+
+    ProblemData data;
+    std::unique_ptr<CostModel> cost;
+    if (!loadData(p.value("data"), data, cost)) return 1;
+
+    SolverParams base;
+    base.polish = p.isSet("polish");
+    base.oscillation = p.isSet("oscillation");
+
+    const Tuner tuner(data, *cost, base);
+    const std::vector<TuneRun> runs = tuner.run(space, options);
+    const std::vector<TuneSummary> summaries = Tuner::summarize(runs);
+
+    if (p.isSet("curves")) {
+        QFile file(p.value("curves"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            err() << "Cannot write: " << p.value("curves") << Qt::endl;
+            return 1;
+        }
+        QTextStream out(&file);
+        out << "config,rung,replica,seconds,iteration,best_cost\n";
+        for (const TuneRun& r : runs)
+            for (const TunePoint& pt : r.curve)
+                out << r.config << "," << r.rung << "," << r.replica << ","
+                    << QString::number(pt.seconds, 'f', 4) << "," << pt.iteration << ","
+                    << QString::number(pt.bestCost, 'f', 4) << "\n";
+    }
+
+    QFile file;
+    if (p.isSet("output")) {
+        file.setFileName(p.value("output"));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            err() << "Cannot write: " << p.value("output") << Qt::endl;
+            return 1;
+        }
+    } else if (!file.open(stdout, QIODevice::WriteOnly | QIODevice::Text)) {
+        return 1;
+    }
+    QTextStream out(&file);
+    out << "config,rung,t0,t1,iterations,swap,choice_move,ranks,shape,mean_cost,best_cost,mean_seconds,pareto\n";
+    for (const TuneSummary& s : summaries) {
+        out << s.config << "," << s.rung << "," << s.params.startTemp << "," << s.params.endTemp << ","
+            << s.params.maxIterations << "," << s.params.moves.swapProbability << ","
+            << s.params.moves.choiceMoveProbability << "," << s.params.moves.choiceRanks << ","
+            << s.params.moves.shapeProbability << ","
+            << QString::number(s.meanCost, 'f', 4) << "," << QString::number(s.bestCost, 'f', 4) << ","
+            << QString::number(s.meanSeconds, 'f', 3) << "," << (s.pareto ? 1 : 0) << "\n";
+    }
+    out.flush();
+
+    const double budget = p.value("budget").toDouble();
+    const std::vector<TuneSummary> best = Tuner::bestWithin(summaries, budget > 0.0 ? budget : 1e300);
+    if (best.empty()) {
+        err() << "No configuration finished within the budget." << Qt::endl;
+        return 0;
+    }
+    const TuneSummary& b = best.front();
+    err() << "best within budget: config " << b.config << " rung " << b.rung
+          << " t0=" << b.params.startTemp << " t1=" << b.params.endTemp
+          << " iterations=" << b.params.maxIterations
+          << " swap=" << b.params.moves.swapProbability
+          << " choice-move=" << b.params.moves.choiceMoveProbability
+          << " ranks=" << b.params.moves.choiceRanks
+          << " shape=" << b.params.moves.shapeProbability
+          << " cost " << QString::number(b.meanCost, 'f', 2)
+          << " in " << QString::number(b.meanSeconds, 'f', 2) << " s" << Qt::endl;
+    return 0;
+}
+
+int runRegress(const QStringList& args)
+{
+    QCommandLineParser p;
+    p.setApplicationDescription("Replay fixed-seed annealing runs and compare them with a baseline:\n"
+                                "final cost, search trajectory and moves/sec.");
+    p.addHelpOption();
+    p.addOption({ "data", "Reference family_data.csv.", "path", "family_data.csv" });
+    p.addOption({ "baseline", "Baseline file.", "path", "regress_baseline.csv" });
+    p.addOption({ "update", "Run the cases below and (over)write the baseline instead of checking." });
+    p.addOption({ "seeds", "Seeds of the runs recorded by --update.", "list", "1,2,3" });
+    p.addOption({ "iterations", "Iterations of the runs recorded by --update.", "n", "2000000" });
+    p.addOption({ "polish", "Include the parallel polish in the runs recorded by --update." });
+    p.addOption({ "threads", "Worker threads for the polish (0 = all cores).", "n", "1" });
+    p.addOption({ "tolerance", "Allowed moves/sec drop relative to the baseline.", "f", "0.2" });
+    p.addOption({ "min-rate", "Absolute moves/sec floor instead of --tolerance (0 = off).", "r", "0" });
+    p.process(args);
+
+    ProblemData data;
+    std::unique_ptr<CostModel> cost;
+    if (!loadData(p.value("data"), data, cost)) return 1;
+    const RegressionRunner runner(data, *cost, p.value("threads").toInt());
+    QTextStream out(stdout);
+    QString e;
+
+    if (p.isSet("update")) {
+        std::vector<uint32_t> seeds;
+        if (!parseList(p.value("seeds"), seeds)) {
+            err() << "Malformed value list." << Qt::endl;
+            return 2;
+        }
+        RegressBaseline baseline;
+        baseline.dataChecksum = data.checksum();
+        for (uint32_t seed : seeds) {
+            baseline.runs.push_back(runner.run(seed, p.value("iterations").toInt(), p.isSet("polish")));
+            const RegressRun& r = baseline.runs.back();
+            out << "seed " << r.seed << " cost " << QString::number(r.finalCost, 'f', 2)
+                << " trajectory " << QString::number((qulonglong)r.trajectory, 16)
+                << " " << QString::number(r.movesPerSecond, 'f', 0) << " moves/s" << Qt::endl;
+        }
+        if (!RegressionRunner::saveBaseline(p.value("baseline"), baseline, &e)) {
+            err() << e << Qt::endl;
+            return 1;
+        }
+        err() << "baseline written to " << p.value("baseline") << Qt::endl;
+        return 0;
+    }
+
+    RegressBaseline baseline;
+    if (!RegressionRunner::loadBaseline(p.value("baseline"), baseline, &e)) {
+        err() << e << Qt::endl;
+        return 1;
+    }
+    if (baseline.dataChecksum != data.checksum()) {
+        err() << "Baseline was recorded on different family data." << Qt::endl;
+        return 1;
+    }
+
+    int failed = 0;
+    for (const RegressCheck& c : runner.check(baseline, p.value("tolerance").toDouble(),
+                                              p.value("min-rate").toDouble())) {
+        out << (c.passed() ? "PASS" : "FAIL") << " seed " << c.actual.seed
+            << " cost " << QString::number(c.actual.finalCost, 'f', 2)
+            << (c.costOk ? "" : QString(" (baseline %1)").arg(c.expected.finalCost, 0, 'f', 2))
+            << " trajectory " << (c.trajectoryOk ? "same" : "DIFFERENT")
+            << " " << QString::number(c.actual.movesPerSecond, 'f', 0) << " moves/s"
+            << " (floor " << QString::number(c.rateFloor, 'f', 0) << ")" << Qt::endl;
+        if (!c.passed()) ++failed;
+    }
+    return failed == 0 ? 0 : 1;
+}
+
+struct Command {
+    const char* name;
+    int (*run)(const QStringList& args);
+};
+
+const Command kCommands[] = {
+    { "island", runIsland },
+    { "islands", runIslands },
+    { "regress", runRegress },
+    { "score", runScore },
+    { "tune", runTune },
+};
+
+} // namespace
+
+bool isCliCommand(const char* arg)
+{
+    for (const auto& c : kCommands)
+        if (std::strcmp(arg, c.name) == 0) return true;
+    return false;
+}
+
+int runCli(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    // Drop the command name so the parser only sees options.
+    const QString name = args.takeAt(1);
+    for (const auto& c : kCommands)
+        if (name == c.name) return c.run(args);
+    return 2;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Headless subcommands: `santa-2019 <command> [options]`. Anything else
+// starts the GUI.
+bool isCliCommand(const char* arg);
+int runCli(int argc, char* argv[]);
@@ -1,4 +1,5 @@
 #include "costmodel.h"
+#include "parallel.h"
 #include <cmath>
 #include <algorithm>
 
@@ -26,16 +27,19 @@ void CostModel::build()
     const int F = m_data.familyCount();
     m_prefCost.assign((size_t)F * 100u, 0u);
     for (int i = 0; i < F; ++i) {
-        const Family& fam = m_data.families()[i];
-        for (int day = 1; day <= 100; ++day) {
-            int rank = 10;
-            for (int r = 0; r < 10; ++r) {
-                if (fam.choices[r] == day) { rank = r; break; }
-            }
-            m_prefCost[(size_t)i * 100u + (size_t)(day - 1)] =
-                preferencePenaltyFromRank(fam.nPeople, rank);
-        }
+        const int n = m_data.familySize(i);
+        const uint8_t* choices = m_data.choices(i);
+        uint32_t* row = &m_prefCost[(size_t)i * 100u];
+        std::fill(row, row + 100, preferencePenaltyFromRank(n, 10));
+        // Highest rank first, so a day listed twice keeps its best rank.
+        for (int r = ProblemData::kChoices - 1; r >= 0; --r)
+            row[choices[r] - 1] = preferencePenaltyFromRank(n, r);
     }
+
+    m_preferring.assign(101, {});
+    for (int r = 0; r < ProblemData::kChoices; ++r)
+        for (int i = 0; i < F; ++i)
+            m_preferring[m_data.choice(i, r)].push_back(i);
 }
 
 uint32_t CostModel::preferenceCost(int familyIndex, int day) const
@@ -52,7 +56,30 @@ double CostModel::accountingDayCost(int Nd, int NdNext)
     return std::max(0.0, raw);
 }
 
+int CostModel::capacityViolation(int Nd)
+{
+    if (Nd < 125) return 125 - Nd;
+    if (Nd > 300) return Nd - 300;
+    return 0;
+}
+
+int CostModel::deltaViolation2(const std::vector<int>& occ,
+                               int dayA, int deltaA,
+                               int dayB, int deltaB)
+{
+    if (dayA == dayB) {
+        return capacityViolation(occ[dayA] + deltaA + deltaB) - capacityViolation(occ[dayA]);
+    }
+    return capacityViolation(occ[dayA] + deltaA) - capacityViolation(occ[dayA])
+         + capacityViolation(occ[dayB] + deltaB) - capacityViolation(occ[dayB]);
+}
+
 double CostModel::accountingCost(const std::vector<int>& occ) const
+{
+    return accountingCost(occ.data());
+}
+
+double CostModel::accountingCost(const int* occ) const
 {
     double sum = 0.0;
     for (int day = 1; day <= 100; ++day) {
@@ -69,22 +96,77 @@ double CostModel::totalCost(const std::vector<int>& assignment,
                             double* outAcc) const
 {
     const int F = m_data.familyCount();
-    std::vector<int> occ(101, 0);
+    std::array<int, 101> occ{};
 
-    double pref = 0.0;
+    int64_t pref = 0;
     for (int i = 0; i < F; ++i) {
         const int day = assignment[i];
-        occ[day] += m_data.families()[i].nPeople;
-        pref += (double)preferenceCost(i, day);
+        occ[day] += m_data.familySize(i);
+        pref += (int64_t)preferenceCost(i, day);
     }
 
-    const double acc = accountingCost(occ);
+    const double acc = accountingCost(occ.data());
 
-    if (outOccupancy) *outOccupancy = occ;
-    if (outPref) *outPref = pref;
+    if (outOccupancy) outOccupancy->assign(occ.begin(), occ.end());
+    if (outPref) *outPref = (double)pref;
     if (outAcc) *outAcc = acc;
 
-    return pref + acc;
+    return (double)pref + acc;
+}
+
+void CostModel::batchTotalCost(const AssignmentBatch& batch,
+                               std::vector<double>& out,
+                               int threads) const
+{
+    // Members are scored in lanes of kLanes; each lane block keeps its own
+    // occupancy rows so the family loop stays sequential over the SoA rows.
+    constexpr int kLanes = 32;
+    const int count = batch.count();
+    const int F = m_data.familyCount();
+    out.assign((size_t)count, 0.0);
+
+    const int blocks = (count + kLanes - 1) / kLanes;
+    parallelFor(blocks, threads, [&](int block) {
+        const int begin = block * kLanes;
+        const int lanes = std::min(kLanes, count - begin);
+
+        std::array<int64_t, kLanes> pref{};
+        std::vector<int> occ((size_t)lanes * 101u, 0);
+
+        for (int f = 0; f < F; ++f) {
+            const int n = m_data.familySize(f);
+            const uint32_t* row = &m_prefCost[(size_t)f * 100u];
+            const uint8_t* days = batch.familyRow(f) + begin;
+            for (int k = 0; k < lanes; ++k) {
+                const int day = days[k];
+                occ[(size_t)k * 101u + (size_t)day] += n;
+                pref[k] += row[day - 1];
+            }
+        }
+
+        for (int k = 0; k < lanes; ++k)
+            out[(size_t)(begin + k)] = (double)pref[k] + accountingCost(&occ[(size_t)k * 101u]);
+    });
+}
+
+void AssignmentBatch::resize(int count, int families)
+{
+    m_count = count;
+    m_families = families;
+    m_days.assign((size_t)count * (size_t)families, 1);
+}
+
+void AssignmentBatch::set(int member, const std::vector<int>& assignment)
+{
+    for (int f = 0; f < m_families; ++f)
+        m_days[(size_t)f * (size_t)m_count + (size_t)member] = (uint8_t)assignment[f];
+}
+
+void AssignmentBatch::get(int member, std::vector<int>& out) const
+{
+    out.resize((size_t)m_families);
+    for (int f = 0; f < m_families; ++f)
+        out[f] = m_days[(size_t)f * (size_t)m_count + (size_t)member];
 }
 
 double CostModel::deltaAccounting2(const std::vector<int>& occ,
@@ -105,7 +187,7 @@ double CostModel::deltaAccounting2(const std::vector<int>& occ,
     };
 
     int candidates[4] = { dayA - 1, dayA, dayB - 1, dayB };
-    int affected[6];
+    int affected[4];
     int k = 0;
     for (int i = 0; i < 4; ++i) {
         int d = candidates[i];
@@ -129,3 +211,65 @@ double CostModel::deltaAccounting2(const std::vector<int>& occ,
 
     return newSum - oldSum;
 }
+
+int64_t AccountingTracker::toFixed(double term)
+{
+    return std::llround(std::min(term, kMaxTerm) * kScale);
+}
+
+void AccountingTracker::reset(const std::vector<int>& occ)
+{
+    m_total = 0;
+    for (int day = 1; day <= 100; ++day) {
+        const int NdNext = (day == 100) ? occ[100] : occ[day + 1];
+        m_dayCost[day] = CostModel::accountingDayCost(occ[day], NdNext);
+        m_dayFixed[day] = toFixed(m_dayCost[day]);
+        m_total += m_dayFixed[day];
+    }
+}
+
+double AccountingTracker::delta(const std::vector<int>& occ,
+                                int dayA, int deltaA,
+                                int dayB, int deltaB,
+                                AccountingTerms* outNew) const
+{
+    auto occNew = [&](int d) -> int {
+        int v = occ[d];
+        if (d == dayA) v += deltaA;
+        if (d == dayB) v += deltaB;
+        return v;
+    };
+
+    const int candidates[4] = { dayA - 1, dayA, dayB - 1, dayB };
+    AccountingTerms terms;
+    int64_t sum = 0;
+    for (int i = 0; i < 4; ++i) {
+        const int d = candidates[i];
+        if (d < 1) continue;
+        bool seen = false;
+        for (int j = 0; j < terms.count; ++j) if (terms.day[j] == d) { seen = true; break; }
+        if (seen) continue;
+
+        const int newNd = occNew(d);
+        const int newNext = (d == 100) ? newNd : occNew(d + 1);
+        const double term = CostModel::accountingDayCost(newNd, newNext);
+        terms.day[terms.count] = d;
+        terms.cost[terms.count] = term;
+        ++terms.count;
+        sum += toFixed(term) - m_dayFixed[d];
+    }
+
+    if (outNew) *outNew = terms;
+    return (double)sum / kScale;
+}
+
+void AccountingTracker::commit(const AccountingTerms& terms)
+{
+    for (int i = 0; i < terms.count; ++i) {
+        const int d = terms.day[i];
+        const int64_t fixed = toFixed(terms.cost[i]);
+        m_total += fixed - m_dayFixed[d];
+        m_dayFixed[d] = fixed;
+        m_dayCost[d] = terms.cost[i];
+    }
+}
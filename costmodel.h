@@ -1,8 +1,37 @@
 #pragma once
 #include "problemdata.h"
+#include <array>
 #include <vector>
 #include <cstdint>
 
+// New accounting terms of the days touched by a proposal, as computed by
+// AccountingTracker::delta, so a commit can store them without re-evaluating.
+struct AccountingTerms {
+    int count = 0;
+    int day[4] = {};
+    double cost[4] = {};
+};
+
+// Structure-of-arrays batch of assignments: the days of family f for all
+// members are stored contiguously, so batch scoring walks each family's cost
+// row once for the whole batch.
+class AssignmentBatch {
+public:
+    void resize(int count, int families);
+
+    int count() const { return m_count; }
+    int families() const { return m_families; }
+
+    void set(int member, const std::vector<int>& assignment);
+    void get(int member, std::vector<int>& out) const;
+    const uint8_t* familyRow(int f) const { return &m_days[(size_t)f * (size_t)m_count]; }
+
+private:
+    int m_count = 0;
+    int m_families = 0;
+    std::vector<uint8_t> m_days;
+};
+
 class CostModel {
 public:
     explicit CostModel(const ProblemData& data);
@@ -10,19 +39,73 @@ public:
     void build();
 
     uint32_t preferenceCost(int familyIndex, int day) const;
+    // Families that list `day` among their choices, best rank first.
+    const std::vector<int>& familiesPreferring(int day) const { return m_preferring[day]; }
     double accountingCost(const std::vector<int>& occupancy) const;
+    double accountingCost(const int* occupancy) const;
     double totalCost(const std::vector<int>& assignment,
                      std::vector<int>* outOccupancy = nullptr,
                      double* outPref = nullptr,
                      double* outAcc = nullptr) const;
+    // Scores every member of `batch` into `out`, split across `threads`
+    // workers (0 = all cores).
+    void batchTotalCost(const AssignmentBatch& batch,
+                        std::vector<double>& out,
+                        int threads = 0) const;
     double deltaAccounting2(const std::vector<int>& occupancy,
                             int dayA, int deltaA,
                             int dayB, int deltaB) const;
 
+    static double accountingDayCost(int Nd, int NdNext);
+
+    // People outside [125, 300] on a day (0 when feasible), and the change in
+    // that total caused by a two-day occupancy change. Used to charge the
+    // penalty in strategic oscillation mode.
+    static int capacityViolation(int Nd);
+    static int deltaViolation2(const std::vector<int>& occupancy,
+                               int dayA, int deltaA,
+                               int dayB, int deltaB);
+
 private:
     const ProblemData& m_data;
     std::vector<uint32_t> m_prefCost;
+    std::vector<std::vector<int>> m_preferring;
 
     static uint32_t preferencePenaltyFromRank(int nPeople, int rank);
-    static double accountingDayCost(int Nd, int NdNext);
+};
+
+// Per-day accounting terms of a live occupancy profile. Old terms are cached,
+// so a delta only evaluates the new terms of the affected days, and the total
+// is available in O(1). The caller keeps the occupancy vector and must commit
+// every accepted change after applying it to that vector.
+//
+// Terms are also held in fixed point (kScale units per cost unit) and the
+// total is their integer sum, like the integer preference cost, so committing
+// millions of deltas never accumulates floating-point error. Each term is
+// rounded by at most 0.5 / kScale, so total() stays within kTolerance of the
+// exact sum. Terms above kMaxTerm only occur far outside the 125/300 bounds
+// and saturate there.
+class AccountingTracker {
+public:
+    static constexpr double kScale = 1048576.0; // 2^20
+    static constexpr double kMaxTerm = 1e10;
+    static constexpr double kTolerance = 101.0 * 0.5 / kScale;
+
+    void reset(const std::vector<int>& occupancy);
+
+    double total() const { return (double)m_total / kScale; }
+    double dayCost(int day) const { return m_dayCost[day]; }
+
+    double delta(const std::vector<int>& occupancy,
+                 int dayA, int deltaA,
+                 int dayB, int deltaB,
+                 AccountingTerms* outNew = nullptr) const;
+    void commit(const AccountingTerms& terms);
+
+private:
+    std::array<double, 101> m_dayCost{};
+    std::array<int64_t, 101> m_dayFixed{};
+    int64_t m_total = 0;
+
+    static int64_t toFixed(double term);
 };
@@ -0,0 +1,43 @@
+#include "elitepool.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+bool before(double cost, uint64_t hash, const ElitePool::Entry& x)
+{
+    return cost < x.cost || (cost == x.cost && hash < x.hash);
+}
+
+} // namespace
+
+ElitePool::ElitePool(int capacity) : m_capacity(std::max(1, capacity))
+{
+    m_entries.reserve((size_t)m_capacity + 1);
+}
+
+bool ElitePool::offer(std::vector<int> assignment, double cost, uint64_t hash)
+{
+    if ((int)m_entries.size() == m_capacity && !before(cost, hash, m_entries.back()))
+        return false;
+    for (const auto& e : m_entries)
+        if (e.hash == hash) return false;
+
+    Entry e;
+    e.assignment = std::move(assignment);
+    e.cost = cost;
+    e.hash = hash;
+
+    auto pos = std::find_if(m_entries.begin(), m_entries.end(),
+                            [&](const Entry& x) { return before(cost, hash, x); });
+    m_entries.insert(pos, std::move(e));
+    if ((int)m_entries.size() > m_capacity) m_entries.pop_back();
+    return true;
+}
+
+std::vector<ElitePool::Entry> ElitePool::takeEntries()
+{
+    std::vector<Entry> out = std::move(m_entries);
+    m_entries.clear();
+    return out;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+
+// Bounded set of the best distinct assignments seen, ordered by cost.
+// Duplicates are detected by Zobrist hash, so offering a state that is
+// already in the pool costs O(capacity) comparisons of 64-bit values.
+// Equal costs are ordered by hash, so the pool's contents and order do not
+// depend on the order in which workers offered their states.
+class ElitePool {
+public:
+    struct Entry {
+        std::vector<int> assignment;
+        double cost = 0.0;
+        uint64_t hash = 0;
+    };
+
+    explicit ElitePool(int capacity);
+
+    // Returns false if the hash is already present or the pool is full of
+    // better entries.
+    bool offer(std::vector<int> assignment, double cost, uint64_t hash);
+
+    std::vector<Entry> takeEntries();
+
+private:
+    int m_capacity = 0;
+    std::vector<Entry> m_entries;
+};
@@ -0,0 +1,203 @@
+#include "genetic.h"
+#include "solver.h"
+#include "parallel.h"
+#include "elitepool.h"
+#include "polisher.h"
+#include "seedstream.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <numeric>
+
+GeneticWorker::GeneticWorker(const ProblemData* data,
+                             const CostModel* cost,
+                             const GeneticParams& params)
+    : m_data(data), m_cost(cost), m_params(params),
+      m_zobrist(data->familyCount())
+{}
+
+void GeneticWorker::stop()
+{
+    m_stop.store(true);
+}
+
+void GeneticWorker::setSnapshots(SnapshotWriter* writer, const SnapshotPolicy& policy)
+{
+    m_snapshots = writer;
+    m_snapshotPolicy = policy;
+}
+
+void GeneticWorker::score(std::vector<Individual>& individuals) const
+{
+    AssignmentBatch batch;
+    batch.resize((int)individuals.size(), m_data->familyCount());
+    for (int i = 0; i < (int)individuals.size(); ++i)
+        batch.set(i, individuals[i].assignment);
+
+    std::vector<double> costs;
+    m_cost->batchTotalCost(batch, costs, m_params.local.threads);
+    for (int i = 0; i < (int)individuals.size(); ++i) {
+        individuals[i].cost = costs[i];
+        individuals[i].hash = m_zobrist.hash(individuals[i].assignment);
+    }
+}
+
+void GeneticWorker::crossover(AnnealState& child,
+                              const std::vector<int>& donor,
+                              std::mt19937& rng) const
+{
+    // Inherit a window of days from the donor: every family the donor places
+    // inside the window, or the child currently places there, is moved to its
+    // donor day whenever the 125/300 bounds allow it.
+    std::uniform_int_distribution<int> startDist(1, 100);
+    std::uniform_int_distribution<int> widthDist(10, 40);
+    const int lo = startDist(rng);
+    const int hi = std::min(100, lo + widthDist(rng) - 1);
+    auto inWindow = [&](int d) { return d >= lo && d <= hi; };
+
+    const int F = m_data->familyCount();
+    std::vector<int> order(F);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    Proposal prop;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int f : order) {
+            const int target = donor[f];
+            const int day = child.assignment()[f];
+            if (day == target) continue;
+            if (!inWindow(target) && !inWindow(day)) continue;
+            if (child.proposeMove(f, target, prop)) child.commit(prop);
+        }
+    }
+}
+
+void GeneticWorker::mutate(AnnealState& child, std::mt19937& rng) const
+{
+    const int F = m_data->familyCount();
+    std::uniform_int_distribution<int> famDist(0, F - 1);
+    std::uniform_int_distribution<int> rankDist(0, 9);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+
+    Proposal prop;
+    for (int step = 0; step < m_params.mutationSteps; ++step) {
+        bool ok;
+        if (uni(rng) < 0.70) {
+            const int f = famDist(rng);
+            ok = child.proposeMove(f, m_data->choice(f, rankDist(rng)), prop);
+        } else {
+            // Named draws: argument evaluation order differs between compilers.
+            const int a = famDist(rng);
+            const int b = famDist(rng);
+            ok = child.proposeSwap(a, b, prop);
+        }
+        if (ok) child.commit(prop);
+    }
+}
+
+void GeneticWorker::run()
+{
+    m_stop.store(false);
+    const int P = std::max(2, m_params.populationSize);
+    const int C = std::max(1, m_params.offspringPerGeneration);
+    const int F = m_data->familyCount();
+
+    // Bursts stop early on stop(), so a stopped run still ends with a valid
+    // (if less refined) population.
+    const SolverParams& local = m_params.local;
+    auto localSearch = [&](AnnealState& state, std::mt19937& rng) {
+        std::vector<int> best = state.assignment();
+        double bestCost = state.cost();
+        annealBurst(state, rng, local.maxIterations, local.startTemp, local.endTemp,
+                    best, bestCost, local.moves, &m_stop);
+        return best;
+    };
+
+    emit log("Building initial population...");
+    std::vector<Individual> population((size_t)P);
+    parallelFor(P, local.threads, [&](int i) {
+        std::mt19937 rng(deriveSeed(local.seed, SeedStream::GeneticInit, (uint64_t)i));
+        AnnealState state(m_data, m_cost);
+        state.reset(makeFeasibleAssignment(m_data, m_cost, rng));
+        population[i].assignment = m_stop.load() ? state.assignment() : localSearch(state, rng);
+    });
+    score(population);
+    // Best first, ordered like the elite pool, even if no generation runs.
+    std::sort(population.begin(), population.end(), [](const Individual& a, const Individual& b) {
+        return a.cost < b.cost || (a.cost == b.cost && a.hash < b.hash);
+    });
+
+    std::mt19937 rng(deriveSeed(local.seed, SeedStream::GeneticSelect));
+    auto tournament = [&]() -> int {
+        std::uniform_int_distribution<int> pick(0, P - 1);
+        const int a = pick(rng);
+        const int b = pick(rng);
+        return population[a].cost <= population[b].cost ? a : b;
+    };
+
+    const QString snapshotBinary = m_snapshotPolicy.binaryPathOrDefault();
+    double snapshotCost = population.front().cost;
+    QElapsedTimer snapshotTimer;
+    snapshotTimer.start();
+
+    emit log("Starting genetic search...");
+    for (int gen = 1; gen <= m_params.generations && !m_stop.load(); ++gen) {
+        // Parents are drawn on this thread so the run does not depend on
+        // how children are scheduled across workers.
+        std::vector<std::pair<int, int>> parents((size_t)C);
+        for (auto& pr : parents) pr = { tournament(), tournament() };
+
+        std::vector<Individual> offspring((size_t)C);
+        parallelFor(C, local.threads, [&](int c) {
+            std::mt19937 crng(deriveSeed(local.seed, SeedStream::GeneticChild, (uint64_t)gen, (uint64_t)c));
+            AnnealState child(m_data, m_cost);
+            child.reset(population[parents[c].first].assignment);
+            crossover(child, population[parents[c].second].assignment, crng);
+            mutate(child, crng);
+            offspring[c].assignment = localSearch(child, crng);
+        });
+        score(offspring);
+
+        // (mu + lambda) replacement; the elite pool drops duplicate states.
+        ElitePool pool(P);
+        for (auto& ind : population) pool.offer(std::move(ind.assignment), ind.cost, ind.hash);
+        for (auto& ind : offspring) pool.offer(std::move(ind.assignment), ind.cost, ind.hash);
+        population.clear();
+        for (auto& e : pool.takeEntries())
+            population.push_back({ std::move(e.assignment), e.cost, e.hash });
+        // Too many duplicates: refill from the best so selection stays valid.
+        while ((int)population.size() < P) population.push_back(population.front());
+
+        double mean = 0.0;
+        for (const auto& ind : population) mean += ind.cost;
+        mean /= (double)P;
+
+        std::vector<int> occ;
+        m_cost->totalCost(population.front().assignment, &occ);
+        QVector<int> occQt(100);
+        for (int d = 1; d <= 100; ++d) occQt[d - 1] = occ[d];
+        emit progress(gen, mean, population.front().cost, occQt);
+
+        const double bestCost = population.front().cost;
+        if (m_snapshots && m_snapshotPolicy.due(bestCost, snapshotCost, snapshotTimer.elapsed())) {
+            m_snapshots->submit(population.front().assignment, bestCost,
+                                m_snapshotPolicy.csvPath, snapshotBinary);
+            snapshotCost = bestCost;
+            snapshotTimer.restart();
+        }
+    }
+
+    Individual& best = population.front();
+    if (local.polish && !m_stop.load()) {
+        emit log("Polishing best assignment...");
+        Polisher(m_data, m_cost).polish(best.assignment, local.threads);
+    }
+
+    const double bestCost = m_cost->totalCost(best.assignment);
+    if (m_snapshots)
+        m_snapshots->submit(best.assignment, bestCost, m_snapshotPolicy.csvPath, snapshotBinary);
+
+    QVector<int> bestQt(F);
+    for (int i = 0; i < F; ++i) bestQt[i] = best.assignment[i];
+
+    emit finished(bestQt, bestCost);
+}
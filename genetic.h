@@ -0,0 +1,77 @@
+#pragma once
+#include <QObject>
+#include <QVector>
+#include <atomic>
+#include <random>
+#include <vector>
+#include "problemdata.h"
+#include "costmodel.h"
+#include "annealstate.h"
+#include "zobrist.h"
+#include "snapshotwriter.h"
+#include "solver.h"
+
+struct GeneticParams {
+    int populationSize = 16;
+    int offspringPerGeneration = 16;
+    int generations = 100;
+    int mutationSteps = 40;             // forced feasible moves/swaps per child
+
+    // Local search: every child gets an annealing burst of maxIterations
+    // steps from startTemp to endTemp with `moves`. seed, threads and polish
+    // apply to the whole run; the other fields are unused.
+    SolverParams local = defaultLocalSearch();
+
+    static SolverParams defaultLocalSearch()
+    {
+        SolverParams p;
+        p.maxIterations = 200000;
+        p.startTemp = 50.0;
+        p.endTemp = 0.5;
+        return p;
+    }
+};
+
+// Memetic engine: (mu + lambda) population of feasible assignments with
+// day-window crossover, move/swap mutation and short annealing bursts as
+// local search. Fitness is scored through CostModel::batchTotalCost.
+class GeneticWorker : public QObject
+{
+    Q_OBJECT
+public:
+    GeneticWorker(const ProblemData* data,
+                  const CostModel* cost,
+                  const GeneticParams& params);
+
+    // Same contract as SolverWorker::setSnapshots; checked once per generation.
+    void setSnapshots(SnapshotWriter* writer, const SnapshotPolicy& policy);
+
+public slots:
+    void run();
+    void stop();
+
+signals:
+    void progress(int generation, double meanCost, double bestCost, QVector<int> occupancy);
+    void finished(QVector<int> bestAssignment, double bestCost);
+    void log(QString msg);
+
+private:
+    struct Individual {
+        std::vector<int> assignment;
+        double cost = 0.0;
+        uint64_t hash = 0;
+    };
+
+    const ProblemData* m_data = nullptr;
+    const CostModel* m_cost = nullptr;
+    GeneticParams m_params;
+    std::atomic_bool m_stop{false};
+    ZobristTable m_zobrist;
+
+    SnapshotWriter* m_snapshots = nullptr;
+    SnapshotPolicy m_snapshotPolicy;
+
+    void score(std::vector<Individual>& individuals) const;
+    void crossover(AnnealState& child, const std::vector<int>& donor, std::mt19937& rng) const;
+    void mutate(AnnealState& child, std::mt19937& rng) const;
+};
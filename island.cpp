@@ -0,0 +1,250 @@
+#include "island.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint64_t kMagic = 0x53414E5441495331ull; // "SANTAIS1"
+constexpr uint32_t kVersion = 2;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "slots need lock-free 64-bit atomics");
+constexpr int kAttachWaitMs = 5000;
+
+size_t alignUp(size_t v, size_t a) { return (v + a - 1) / a * a; }
+
+} // namespace
+
+struct IslandExchange::Header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t islands;
+    uint32_t families;
+    std::atomic<uint32_t> ready;
+    uint64_t campaign;
+    uint64_t dataChecksum;
+    std::atomic<uint32_t> attached;  // processes that opened and have not closed
+};
+
+// Followed by the days, eight per 64-bit word.
+struct IslandExchange::Slot {
+    std::atomic<uint64_t> seq;  // 0 = never written, odd = write in progress
+    std::atomic<int64_t> pid;
+    std::atomic<int32_t> island;
+    std::atomic<uint64_t> hash;
+    std::atomic<double> cost;
+};
+
+IslandExchange::~IslandExchange()
+{
+    close();
+}
+
+IslandExchange::Header* IslandExchange::header() const
+{
+    return static_cast<Header*>(m_base);
+}
+
+IslandExchange::Slot* IslandExchange::slot(int i) const
+{
+    char* base = static_cast<char*>(m_base) + alignUp(sizeof(Header), 64);
+    return reinterpret_cast<Slot*>(base + m_slotStride * (size_t)i);
+}
+
+std::atomic<uint64_t>* IslandExchange::slotWords(int i) const
+{
+    return reinterpret_cast<std::atomic<uint64_t>*>(reinterpret_cast<char*>(slot(i)) + sizeof(Slot));
+}
+
+bool IslandExchange::open(const QString& name, int islands, int families,
+                          uint64_t campaign, uint64_t dataChecksum, QString* errorOut)
+{
+    close();
+    if (islands < 1 || families < 1) {
+        if (errorOut) *errorOut = "Invalid island segment geometry.";
+        return false;
+    }
+
+    m_slots = islands;
+    m_families = families;
+    m_slotStride = alignUp(sizeof(Slot) + ((size_t)families + 7) / 8 * sizeof(uint64_t), 64);
+    m_size = alignUp(sizeof(Header), 64) + m_slotStride * (size_t)islands;
+
+    const QByteArray key = name.toLocal8Bit();
+    bool creator = true;
+    int fd = shm_open(key.constData(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        creator = false;
+        fd = shm_open(key.constData(), O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        if (errorOut) *errorOut = "Cannot open shared memory " + name + ": " + QString::fromLocal8Bit(std::strerror(errno));
+        return false;
+    }
+
+    if (creator) {
+        if (ftruncate(fd, (off_t)m_size) != 0) {
+            if (errorOut) *errorOut = "Cannot size shared memory " + name;
+            ::close(fd);
+            shm_unlink(key.constData());
+            return false;
+        }
+    } else {
+        // The creator sizes the segment right after creating it.
+        struct stat st{};
+        for (int waited = 0; waited < kAttachWaitMs; waited += 10) {
+            if (fstat(fd, &st) == 0 && (size_t)st.st_size >= m_size) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        if ((size_t)st.st_size < m_size) {
+            if (errorOut) *errorOut = "Shared memory " + name + " is smaller than expected (different geometry or a dead creator).";
+            ::close(fd);
+            return false;
+        }
+    }
+
+    void* base = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        if (errorOut) *errorOut = "Cannot map shared memory " + name;
+        return false;
+    }
+    m_base = base;
+    m_name = key;
+
+    Header* h = header();
+    if (creator) {
+        h->magic = kMagic;
+        h->version = kVersion;
+        h->islands = (uint32_t)islands;
+        h->families = (uint32_t)families;
+        h->campaign = campaign;
+        h->dataChecksum = dataChecksum;
+        h->attached.store(1, std::memory_order_relaxed);
+        m_attached = true;
+        h->ready.store(1, std::memory_order_release);
+        return true;
+    }
+
+    for (int waited = 0; waited < kAttachWaitMs; waited += 10) {
+        if (h->ready.load(std::memory_order_acquire) == 1) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (h->ready.load(std::memory_order_acquire) != 1 || h->magic != kMagic || h->version != kVersion
+        || h->islands != (uint32_t)islands || h->families != (uint32_t)families) {
+        if (errorOut) *errorOut = "Shared memory " + name + " has a different layout.";
+        close();
+        return false;
+    }
+    if (h->campaign != campaign || h->dataChecksum != dataChecksum) {
+        if (errorOut) *errorOut = "Shared memory " + name + " belongs to another campaign or family data"
+                                  " (remove it or use another --segment).";
+        close();
+        return false;
+    }
+    h->attached.fetch_add(1, std::memory_order_acq_rel);
+    m_attached = true;
+    return true;
+}
+
+void IslandExchange::close()
+{
+    if (m_base) {
+        // The last process out removes the segment, so a later campaign with
+        // the same name starts from an empty one.
+        if (m_attached && header()->attached.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            shm_unlink(m_name.constData());
+        munmap(m_base, m_size);
+    }
+    m_base = nullptr;
+    m_size = 0;
+    m_attached = false;
+}
+
+bool IslandExchange::unlink(const QString& name)
+{
+    return shm_unlink(name.toLocal8Bit().constData()) == 0;
+}
+
+bool IslandExchange::publish(int island, const std::vector<int>& assignment, double cost, uint64_t hash)
+{
+    if (!m_base || island < 0 || island >= m_slots || (int)assignment.size() != m_families)
+        return false;
+
+    Slot* s = slot(island);
+    uint64_t seq = s->seq.load(std::memory_order_relaxed);
+    if (seq & 1) ++seq; // a previous owner of this slot died mid-write
+    s->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    constexpr auto relaxed = std::memory_order_relaxed;
+    s->pid.store((int64_t)getpid(), relaxed);
+    s->island.store(island, relaxed);
+    s->hash.store(hash, relaxed);
+    s->cost.store(cost, relaxed);
+    std::atomic<uint64_t>* words = slotWords(island);
+    for (int w = 0; w * 8 < m_families; ++w) {
+        uint64_t packed = 0;
+        for (int k = 0; k < 8 && w * 8 + k < m_families; ++k)
+            packed |= (uint64_t)(uint8_t)assignment[w * 8 + k] << (8 * k);
+        words[w].store(packed, relaxed);
+    }
+
+    s->seq.store(seq + 2, std::memory_order_release);
+    return true;
+}
+
+bool IslandExchange::read(int i, Migrant& out) const
+{
+    if (!m_base || i < 0 || i >= m_slots) return false;
+
+    const Slot* s = slot(i);
+    const uint64_t before = s->seq.load(std::memory_order_acquire);
+    if (before == 0 || (before & 1)) return false;
+
+    constexpr auto relaxed = std::memory_order_relaxed;
+    out.pid = s->pid.load(relaxed);
+    out.island = s->island.load(relaxed);
+    out.hash = s->hash.load(relaxed);
+    out.cost = s->cost.load(relaxed);
+    out.assignment.resize((size_t)m_families);
+    const std::atomic<uint64_t>* words = slotWords(i);
+    for (int w = 0; w * 8 < m_families; ++w) {
+        const uint64_t packed = words[w].load(relaxed);
+        for (int k = 0; k < 8 && w * 8 + k < m_families; ++k)
+            out.assignment[w * 8 + k] = (int)((packed >> (8 * k)) & 0xFF);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (s->seq.load(std::memory_order_relaxed) != before) return false;
+
+    for (int d : out.assignment)
+        if (d < 1 || d > 100) return false;
+    return true;
+}
+
+bool IslandExchange::alive(int i) const
+{
+    if (!m_base || i < 0 || i >= m_slots) return false;
+    const int64_t pid = slot(i)->pid.load(std::memory_order_relaxed);
+    if (pid <= 0) return false;
+    return kill((pid_t)pid, 0) == 0 || errno == EPERM;
+}
+
+MigrationPolicy IslandExchange::policyFromString(const QString& s, bool* ok)
+{
+    if (ok) *ok = true;
+    if (s == "best") return MigrationPolicy::Best;
+    if (s == "ring") return MigrationPolicy::Ring;
+    if (s == "random") return MigrationPolicy::Random;
+    if (ok) *ok = false;
+    return MigrationPolicy::Best;
+}
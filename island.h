@@ -0,0 +1,80 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+enum class MigrationPolicy {
+    Best,    // import the best elite published by any other island
+    Ring,    // import from the previous island id only
+    Random,  // import from a random other island
+};
+
+struct MigrationParams {
+    int everyIterations = 200000;     // publish + import period
+    MigrationPolicy policy = MigrationPolicy::Best;
+    double minImprovement = 1e-6;     // import only if this much better than the current state
+};
+
+struct Migrant {
+    std::vector<int> assignment;
+    double cost = 0.0;
+    uint64_t hash = 0;
+    int island = -1;
+    int64_t pid = 0;
+};
+
+// Elite exchange between solver processes through a POSIX shared-memory
+// segment. Every island owns one slot and overwrites it with its current
+// best; readers copy a slot under a sequence lock, so a process that dies
+// mid-write only leaves its own slot unreadable and never blocks anyone.
+// All slot fields are atomics accessed relaxed inside the lock, so a torn
+// read is detected by the sequence check rather than being a data race.
+//
+// The header carries a campaign id and a checksum of the family data; an
+// island only attaches to a segment of its own campaign and data. The last
+// process to close() cleanly unlinks the segment; a process that dies without
+// close() keeps it counted, so the segment then outlives the campaign until
+// it is unlinked by hand.
+class IslandExchange {
+public:
+    IslandExchange() = default;
+    ~IslandExchange();
+    IslandExchange(const IslandExchange&) = delete;
+    IslandExchange& operator=(const IslandExchange&) = delete;
+
+    // Creates the segment or attaches to an existing one with the same
+    // geometry, campaign and data. `name` is a POSIX shm name such as
+    // "/santa-islands"; `dataChecksum` is ProblemData::checksum().
+    bool open(const QString& name, int islands, int families,
+              uint64_t campaign, uint64_t dataChecksum, QString* errorOut = nullptr);
+    void close();
+    static bool unlink(const QString& name);
+
+    int slotCount() const { return m_slots; }
+
+    bool publish(int island, const std::vector<int>& assignment, double cost, uint64_t hash);
+    // False if the slot is empty or was being written while it was read.
+    bool read(int slot, Migrant& out) const;
+    // The slot owner's process still exists.
+    bool alive(int slot) const;
+
+    static MigrationPolicy policyFromString(const QString& s, bool* ok = nullptr);
+
+private:
+    struct Header;
+    struct Slot;
+
+    QByteArray m_name;
+    void* m_base = nullptr;
+    size_t m_size = 0;
+    bool m_attached = false;   // counted in Header::attached
+    int m_slots = 0;
+    int m_families = 0;
+    size_t m_slotStride = 0;
+
+    Header* header() const;
+    Slot* slot(int i) const;
+    std::atomic<uint64_t>* slotWords(int i) const;
+};
@@ -2,9 +2,13 @@
 #include <QMetaType>
 #include <QVector>
 #include "mainwindow.h"
+#include "cli.h"
 
 int main(int argc, char *argv[])
 {
+    if (argc > 1 && isCliCommand(argv[1]))
+        return runCli(argc, argv);
+
     QApplication app(argc, argv);
 
     qRegisterMetaType<QVector<int>>("QVector<int>");
@@ -5,11 +5,13 @@
 #include <QPushButton>
 #include <QSpinBox>
 #include <QDoubleSpinBox>
+#include <QComboBox>
+#include <QCheckBox>
 #include <QLabel>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QDir>
 #include <QMessageBox>
-#include <QFile>
-#include <QTextStream>
 
 #include <QtCharts/QChart>.
 #include <QtCharts/QValueAxis>
@@ -20,11 +22,21 @@ MainWindow::MainWindow(QWidget *parent)
 {
     setupUi();
     resetCharts();
+
+    m_writer = std::make_unique<SnapshotWriter>(&m_data);
+    connect(m_writer.get(), &SnapshotWriter::written, this, &MainWindow::onSnapshotWritten);
+    connect(m_writer.get(), &SnapshotWriter::failed, this, &MainWindow::onSnapshotFailed);
 }
 
 MainWindow::~MainWindow()
 {
     onStop();
+    // A stopped worker still submits its final snapshot, so every solver
+    // thread (also ones stopped earlier) must end before m_writer goes.
+    for (QThread* thread : findChildren<QThread*>()) {
+        thread->quit();
+        thread->wait();
+    }
 }
 
 void MainWindow::setupUi()
@@ -60,7 +72,19 @@ void MainWindow::setupUi()
     m_spinT1->setDecimals(4);
     m_spinT1->setValue(1.0);
 
+    m_spinSeed = new QSpinBox();
+    m_spinSeed->setRange(0, 2147483647);
+    m_spinSeed->setValue(42);
+    m_spinSeed->setToolTip("Master seed; the same seed reproduces the same run");
+
+    m_engine = new QComboBox();
+    m_engine->addItem("Annealing");
+    m_engine->addItem("Genetic");
+    connect(m_engine, qOverload<int>(&QComboBox::currentIndexChanged), this, &MainWindow::onEngineChanged);
+
     controls->addWidget(m_btnLoad);
+    controls->addWidget(new QLabel("Engine:"));
+    controls->addWidget(m_engine);
     controls->addWidget(new QLabel("Iters:"));
     controls->addWidget(m_spinIters);
     controls->addWidget(new QLabel("ReportEvery:"));
@@ -69,6 +93,14 @@ void MainWindow::setupUi()
     controls->addWidget(m_spinT0);
     controls->addWidget(new QLabel("T1:"));
     controls->addWidget(m_spinT1);
+    controls->addWidget(new QLabel("Seed:"));
+    controls->addWidget(m_spinSeed);
+    m_chkOscillation = new QCheckBox("Oscillation");
+    m_chkOscillation->setToolTip("Allow 125/300 violations at an adaptive penalty");
+    controls->addWidget(m_chkOscillation);
+    m_chkAutosave = new QCheckBox("Autosave");
+    m_chkAutosave->setToolTip("Write submission.autosave.csv/.bin next to family_data.csv while solving");
+    controls->addWidget(m_chkAutosave);
     controls->addWidget(m_btnStart);
     controls->addWidget(m_btnStop);
     controls->addWidget(m_btnSave);
@@ -172,6 +204,9 @@ void MainWindow::onLoadFamilyData()
 
     if (path.isEmpty()) return;
 
+    // Pending snapshots still read the old family ids.
+    m_writer->flush();
+
     QString err;
     if (!m_data.loadFamilyCsv(path, &err)) {
         QMessageBox::critical(this, "Load failed", err);
@@ -180,6 +215,7 @@ void MainWindow::onLoadFamilyData()
 
     m_cost = std::make_unique<CostModel>(m_data);
     m_cost->build();
+    m_autosaveDir = QFileInfo(path).absolutePath();
 
     m_btnStart->setEnabled(true);
     m_status->setText(QString("Loaded %1 families. Total people=%2. Ready.")
@@ -197,15 +233,50 @@ void MainWindow::onStart()
     m_btnStop->setEnabled(true);
     m_btnSave->setEnabled(false);
 
-    SolverParams params;
-    params.maxIterations = m_spinIters->value();
-    params.reportEvery = m_spinReport->value();
-    params.startTemp = m_spinT0->value();
-    params.endTemp = m_spinT1->value();
-    params.seed = 42;
-
     m_thread = new QThread(this);
-    m_worker = new SolverWorker(&m_data, m_cost.get(), QVector<int>(), params);
+
+    // For the genetic engine Iters/T0/T1 describe each child's local search.
+    SolverParams solverParams;
+    solverParams.maxIterations = m_spinIters->value();
+    solverParams.reportEvery = m_spinReport->value();
+    solverParams.startTemp = m_spinT0->value();
+    solverParams.endTemp = m_spinT1->value();
+    solverParams.oscillation = m_chkOscillation->isChecked();
+    solverParams.seed = (uint32_t)m_spinSeed->value();
+
+    SnapshotPolicy autosave;
+    autosave.csvPath = QDir(m_autosaveDir).filePath("submission.autosave.csv");
+
+    if (m_engine->currentIndex() == 1) {
+        GeneticParams params;
+        params.local = solverParams;
+
+        m_genetic = new GeneticWorker(&m_data, m_cost.get(), params);
+        if (m_chkAutosave->isChecked()) m_genetic->setSnapshots(m_writer.get(), autosave);
+        m_genetic->moveToThread(m_thread);
+
+        connect(m_thread, &QThread::started, m_genetic, &GeneticWorker::run);
+        connect(m_genetic, &GeneticWorker::progress, this, &MainWindow::onSolverProgress);
+        connect(m_genetic, &GeneticWorker::finished, this, &MainWindow::onSolverFinished);
+        connect(m_genetic, &GeneticWorker::log, this, &MainWindow::onSolverLog);
+
+        connect(m_genetic, &GeneticWorker::finished, m_thread, &QThread::quit);
+        connect(m_thread, &QThread::finished, m_genetic, &QObject::deleteLater);
+        connect(m_thread, &QThread::finished, m_thread, &QObject::deleteLater);
+
+        auto axes = m_costView->chart()->axes(Qt::Horizontal);
+        if (!axes.isEmpty()) {
+            auto* x = qobject_cast<QValueAxis*>(axes.first());
+            if (x) x->setRange(0, params.generations);
+        }
+
+        m_thread->start();
+        m_status->setText("Genetic solver started...");
+        return;
+    }
+
+    m_worker = new SolverWorker(&m_data, m_cost.get(), QVector<int>(), solverParams);
+    if (m_chkAutosave->isChecked()) m_worker->setSnapshots(m_writer.get(), autosave);
     m_worker->moveToThread(m_thread);
 
     connect(m_thread, &QThread::started, m_worker, &SolverWorker::run);
@@ -225,13 +296,28 @@ void MainWindow::onStart()
 void MainWindow::onStop()
 {
     if (m_worker) m_worker->stop();
+    if (m_genetic) m_genetic->stop();
     m_worker = nullptr;
+    m_genetic = nullptr;
     m_thread = nullptr;
 
     m_btnStart->setEnabled(m_cost != nullptr);
     m_btnStop->setEnabled(false);
 }
 
+void MainWindow::onEngineChanged(int index)
+{
+    // Load the engine's defaults; the genetic engine reads Iters/T0/T1 as its
+    // per-child annealing burst and has no report interval or oscillation.
+    const bool genetic = index == 1;
+    const SolverParams p = genetic ? GeneticParams::defaultLocalSearch() : SolverParams();
+    m_spinIters->setValue(p.maxIterations);
+    m_spinT0->setValue(p.startTemp);
+    m_spinT1->setValue(p.endTemp);
+    m_spinReport->setEnabled(!genetic);
+    m_chkOscillation->setEnabled(!genetic);
+}
+
 void MainWindow::onSave()
 {
     if (m_bestAssignment.isEmpty()) return;
@@ -240,19 +326,31 @@ void MainWindow::onSave()
         this, "Save submission.csv", "submission.csv", "CSV (*.csv)");
     if (path.isEmpty()) return;
 
-    QFile f(path);
-    if (!f.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::critical(this, "Save failed", "Cannot write: " + path);
+    // Formatting and writing happen on the snapshot thread.
+    const std::vector<int> assignment(m_bestAssignment.begin(), m_bestAssignment.end());
+    m_manualSavePath = path;
+    m_writer->submit(assignment, m_bestCost, path, SnapshotWriter::binaryPathFor(path));
+    m_status->setText("Saving " + path + "...");
+}
+
+void MainWindow::onSnapshotWritten(const QString& csvPath, double cost)
+{
+    if (csvPath == m_manualSavePath) {
+        m_manualSavePath.clear();
+        m_status->setText("Saved: " + csvPath);
         return;
     }
+    m_status->setText(QString("Autosaved best %1 to %2").arg(cost, 0, 'f', 2).arg(csvPath));
+}
 
-    QTextStream out(&f);
-    out << "family_id,assigned_day\n";
-    for (int i = 0; i < m_data.familyCount(); ++i) {
-        out << m_data.families()[i].id << "," << m_bestAssignment[i] << "\n";
+void MainWindow::onSnapshotFailed(const QString& csvPath, const QString& error)
+{
+    if (csvPath == m_manualSavePath) {
+        m_manualSavePath.clear();
+        QMessageBox::critical(this, "Save failed", error);
+        return;
     }
-
-    m_status->setText("Saved: " + path);
+    m_status->setText("Autosave failed: " + error);
 }
 
 void MainWindow::onSolverProgress(int iter, double currentCost, double bestCost, QVector<int> occupancy)
@@ -6,6 +6,7 @@
 #include "problemdata.h"
 #include "costmodel.h"
 #include "solver.h"
+#include "genetic.h"
 
 // Qt Charts
 #include <QtCharts/QChartView>
@@ -16,6 +17,8 @@ class QLabel;
 class QPushButton;
 class QSpinBox;
 class QDoubleSpinBox;
+class QComboBox;
+class QCheckBox;
 
 class MainWindow : public QMainWindow
 {
@@ -29,10 +32,13 @@ private slots:
     void onStart();
     void onStop();
     void onSave();
+    void onEngineChanged(int index);
 
     void onSolverProgress(int iter, double currentCost, double bestCost, QVector<int> occupancy);
     void onSolverFinished(QVector<int> bestAssignment, double bestCost);
     void onSolverLog(const QString& msg);
+    void onSnapshotWritten(const QString& csvPath, double cost);
+    void onSnapshotFailed(const QString& csvPath, const QString& error);
 
 private:
     void setupUi();
@@ -42,6 +48,11 @@ private:
 
     ProblemData m_data;
     std::unique_ptr<CostModel> m_cost;
+    // Declared after m_data so it drains and joins before m_data goes away;
+    // the destructor joins the solver threads that submit to it first.
+    std::unique_ptr<SnapshotWriter> m_writer;
+    QString m_autosaveDir;
+    QString m_manualSavePath;
 
     QVector<int> m_bestAssignment;
     double m_bestCost = 0.0;
@@ -56,6 +67,10 @@ private:
     QSpinBox* m_spinReport = nullptr;
     QDoubleSpinBox* m_spinT0 = nullptr;
     QDoubleSpinBox* m_spinT1 = nullptr;
+    QSpinBox* m_spinSeed = nullptr;
+    QComboBox* m_engine = nullptr;
+    QCheckBox* m_chkOscillation = nullptr;
+    QCheckBox* m_chkAutosave = nullptr;
 
     QLabel* m_status = nullptr;
 
@@ -73,4 +88,5 @@ private:
     // Solver thread
     QThread* m_thread = nullptr;
     SolverWorker* m_worker = nullptr;
+    GeneticWorker* m_genetic = nullptr;
 };
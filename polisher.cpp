@@ -0,0 +1,199 @@
+#include "polisher.h"
+#include "annealstate.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+struct Candidate {
+    int f1 = -1;
+    int f2 = -1;   // -1 for a move
+    int from = 0;  // day of f1 at scan time
+    int day = 0;   // day f1 goes to
+    double delta = 0.0;
+};
+
+// Changes smaller than this are treated as noise, which also guarantees
+// every committed round strictly lowers the cost.
+constexpr double kMinGain = 1e-7;
+constexpr int kScanBlock = 64;
+
+} // namespace
+
+Polisher::Polisher(const ProblemData* data, const CostModel* cost)
+    : m_data(data), m_cost(cost)
+{}
+
+PolishStats Polisher::polish(std::vector<int>& assignment, int threads, int maxRounds) const
+{
+    const int F = m_data->familyCount();
+    AnnealState state(m_data, m_cost);
+    state.reset(assignment);
+    const double startCost = state.cost();
+
+    const std::vector<int>& sizes = state.familySizes();  // ascending
+    const int maxSize = sizes.empty() ? 0 : sizes.back();
+    const int S = maxSize + 1;      // family sizes 0..maxSize
+    const int K = 2 * maxSize + 1;  // size differences -maxSize..maxSize
+    const double inf = std::numeric_limits<double>::infinity();
+    const int64_t noFamily = std::numeric_limits<int64_t>::max();
+
+    std::vector<char> sizePresent((size_t)S, 0);
+    for (int n : sizes) sizePresent[n] = 1;
+
+    std::vector<double> singleAcc((size_t)101 * (size_t)K);
+    std::vector<double> moveAcc((size_t)101 * 101 * (size_t)S);
+    std::vector<double> swapAcc((size_t)101 * 101 * (size_t)K);
+    auto moveAt = [&](int a, int b, int n) -> double {
+        return moveAcc[((size_t)a * 101 + (size_t)b) * (size_t)S + (size_t)n];
+    };
+    auto swapAt = [&](int a, int b, int k) -> double {
+        return swapAcc[((size_t)a * 101 + (size_t)b) * (size_t)K + (size_t)(k + maxSize)];
+    };
+
+    // partner[(d2 * S + n2) * 101 + d1]: among families of size n2 on day
+    // d2, the lowest pref(f2, d1) - pref(f2, d2) and the family reaching it.
+    // With it the best swap partner of f1 for each (d2, n2) is a lookup.
+    std::vector<int64_t> partnerGain((size_t)101 * (size_t)S * 101);
+    std::vector<int> partnerFam(partnerGain.size());
+    auto partnerIndex = [&](int d2, int n2, int d1) -> size_t {
+        return ((size_t)d2 * (size_t)S + (size_t)n2) * 101 + (size_t)d1;
+    };
+
+    std::vector<Candidate> best((size_t)F);
+    std::vector<char> locked(102, 0);
+
+    PolishStats stats;
+    while (stats.rounds < maxRounds) {
+        ++stats.rounds;
+        const std::vector<int>& cur = state.assignment();
+        const std::vector<int>& occ = state.occupancy();
+        const AccountingTracker& acc = state.accounting();
+
+        // Accounting deltas only depend on (from, to, people moved), so they
+        // are tabulated once per round; infeasible entries are +inf. For days
+        // at least two apart the affected terms are disjoint and the delta is
+        // the sum of two single-day changes.
+        for (int a = 1; a <= 100; ++a)
+            for (int x = -maxSize; x <= maxSize; ++x)
+                singleAcc[(size_t)a * (size_t)K + (size_t)(x + maxSize)] = acc.delta(occ, a, x, a, 0);
+        auto pairDelta = [&](int a, int x, int b) -> double {
+            if (std::abs(a - b) <= 1) return acc.delta(occ, a, x, b, -x);
+            return singleAcc[(size_t)a * (size_t)K + (size_t)(x + maxSize)]
+                 + singleAcc[(size_t)b * (size_t)K + (size_t)(maxSize - x)];
+        };
+
+        parallelFor(100, threads, [&](int i) {
+            const int a = i + 1;
+            for (int b = 1; b <= 100; ++b) {
+                double* mrow = &moveAcc[((size_t)a * 101 + (size_t)b) * (size_t)S];
+                double* srow = &swapAcc[((size_t)a * 101 + (size_t)b) * (size_t)K];
+                for (int n = 0; n < S; ++n) {
+                    const bool ok = sizePresent[n] && a != b
+                        && occ[a] - n >= 125 && occ[b] + n <= 300;
+                    mrow[n] = ok ? pairDelta(a, -n, b) : inf;
+                }
+                // A family of size n1 leaves a and one of size n1 + k arrives.
+                for (int k = -maxSize; k <= maxSize; ++k) {
+                    const bool ok = a != b
+                        && occ[a] + k >= 125 && occ[a] + k <= 300
+                        && occ[b] - k >= 125 && occ[b] - k <= 300;
+                    srow[k + maxSize] = ok ? pairDelta(a, k, b) : inf;
+                }
+            }
+        });
+
+        parallelFor(100, threads, [&](int i) {
+            const int d2 = i + 1;
+            for (int n2 : sizes) {
+                std::fill(&partnerGain[partnerIndex(d2, n2, 0)],
+                          &partnerGain[partnerIndex(d2, n2, 0)] + 101, noFamily);
+                for (int f2 : state.familiesOnDay(d2, n2)) {
+                    const int64_t stay = m_cost->preferenceCost(f2, d2);
+                    for (int d1 = 1; d1 <= 100; ++d1) {
+                        const int64_t g = (int64_t)m_cost->preferenceCost(f2, d1) - stay;
+                        const size_t idx = partnerIndex(d2, n2, d1);
+                        if (g < partnerGain[idx]) {
+                            partnerGain[idx] = g;
+                            partnerFam[idx] = f2;
+                        }
+                    }
+                }
+            }
+        });
+
+        // Best improving move or swap per family. A pair can be found from
+        // both sides; the commit pass below takes it at most once.
+        const int blocks = (F + kScanBlock - 1) / kScanBlock;
+        parallelFor(blocks, threads, [&](int block) {
+            const int end = std::min(F, (block + 1) * kScanBlock);
+            for (int f1 = block * kScanBlock; f1 < end; ++f1) {
+                const int d1 = cur[f1];
+                const int n1 = m_data->familySize(f1);
+                const int64_t p1 = m_cost->preferenceCost(f1, d1);
+
+                Candidate c;
+                c.delta = -kMinGain;
+                const uint8_t* choices = m_data->choices(f1);
+                for (int r = 0; r < ProblemData::kChoices; ++r) {
+                    const int d = choices[r];
+                    if (d == d1) continue;
+                    const double delta =
+                        (double)((int64_t)m_cost->preferenceCost(f1, d) - p1) + moveAt(d1, d, n1);
+                    if (delta < c.delta) c = { f1, -1, d1, d, delta };
+                }
+
+                for (int d2 = 1; d2 <= 100; ++d2) {
+                    if (d2 == d1) continue;
+                    const int64_t p1To = (int64_t)m_cost->preferenceCost(f1, d2) - p1;
+                    for (int n2 : sizes) {
+                        const size_t idx = partnerIndex(d2, n2, d1);
+                        if (partnerGain[idx] == noFamily) continue;
+                        const double a = swapAt(d1, d2, n2 - n1);
+                        if (a == inf) continue;
+                        const double delta = (double)(p1To + partnerGain[idx]) + a;
+                        if (delta < c.delta) c = { f1, partnerFam[idx], d1, d2, delta };
+                    }
+                }
+                best[f1] = c;
+            }
+        });
+
+        std::vector<Candidate> found;
+        for (const auto& c : best)
+            if (c.f1 >= 0) found.push_back(c);
+        if (found.empty()) break;
+        std::stable_sort(found.begin(), found.end(),
+                         [](const Candidate& x, const Candidate& y) { return x.delta < y.delta; });
+
+        // Commit greedily; a change touches the accounting terms of its days
+        // and their neighbours, so overlapping windows are deferred to the
+        // next round where they are re-evaluated.
+        std::fill(locked.begin(), locked.end(), 0);
+        auto windowFree = [&](int d) { return !locked[d - 1] && !locked[d] && !locked[d + 1]; };
+        auto lockWindow = [&](int d) { locked[d - 1] = locked[d] = locked[d + 1] = 1; };
+
+        int committed = 0;
+        for (const auto& c : found) {
+            if (!windowFree(c.from) || !windowFree(c.day)) continue;
+            Proposal p;
+            const bool ok = (c.f2 < 0) ? state.proposeMove(c.f1, c.day, p)
+                                       : state.proposeSwap(c.f1, c.f2, p);
+            if (!ok || p.delta >= -kMinGain) continue;
+            state.commit(p);
+            lockWindow(c.from);
+            lockWindow(c.day);
+            ++committed;
+            if (c.f2 < 0) ++stats.moves; else ++stats.swaps;
+        }
+        // Tabulated deltas are summed in a different order than the exact
+        // ones; if only rounding-level candidates remain we are done.
+        if (committed == 0) break;
+    }
+
+    assignment = state.assignment();
+    stats.gain = startCost - state.cost();
+    return stats;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include "problemdata.h"
+#include "costmodel.h"
+
+struct PolishStats {
+    int rounds = 0;
+    int moves = 0;
+    int swaps = 0;
+    double gain = 0.0;
+};
+
+// Deterministic steepest descent over the full move neighbourhood (every
+// family to each of its 10 choices) and swap neighbourhood (every pair of
+// families on different days). Each round scans all families in parallel,
+// then commits a batch of improving changes whose affected days do not
+// overlap, until no improving move or swap is left.
+class Polisher {
+public:
+    Polisher(const ProblemData* data, const CostModel* cost);
+
+    PolishStats polish(std::vector<int>& assignment,
+                       int threads = 0,
+                       int maxRounds = 100000) const;
+
+private:
+    const ProblemData* m_data = nullptr;
+    const CostModel* m_cost = nullptr;
+};
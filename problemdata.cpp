@@ -1,5 +1,6 @@
 #include "problemdata.h"
 #include <QFile>
+#include <QSaveFile>
 #include <QTextStream>
 
 bool ProblemData::loadFamilyCsv(const QString& path, QString* errorOut)
@@ -17,29 +18,99 @@ bool ProblemData::loadFamilyCsv(const QString& path, QString* errorOut)
         return false;
     }
 
-    m_families.clear();
-    m_totalPeople = 0;
+    // Parsed into locals so a rejected file leaves the current data intact.
+    std::vector<int> ids;
+    std::vector<uint8_t> sizes;
+    std::vector<uint8_t> choices;
+    int totalPeople = 0;
 
+    int lineNo = 1;
     while (!in.atEnd()) {
         const QString line = in.readLine().trimmed();
+        ++lineNo;
         if (line.isEmpty()) continue;
 
         const QStringList parts = line.split(',');
         if (parts.size() < 12) continue;
 
-        Family fam;
-        fam.id = parts[0].toInt();
-        for (int i = 0; i < 10; ++i)
-            fam.choices[i] = parts[1 + i].toInt();
-        fam.nPeople = parts[11].toInt();
+        for (int i = 0; i < kChoices; ++i) {
+            const int day = parts[1 + i].toInt();
+            if (day < 1 || day > 100) {
+                if (errorOut) *errorOut = QString("Line %1: choice day %2 out of range 1..100.").arg(lineNo).arg(day);
+                return false;
+            }
+            choices.push_back((uint8_t)day);
+        }
+        const int nPeople = parts[11].toInt();
+        if (nPeople < 1 || nPeople > kMaxFamilySize) {
+            if (errorOut) *errorOut = QString("Line %1: family size %2 out of range 1..%3.")
+                                          .arg(lineNo).arg(nPeople).arg(kMaxFamilySize);
+            return false;
+        }
 
-        m_totalPeople += fam.nPeople;
-        m_families.push_back(fam);
+        ids.push_back(parts[0].toInt());
+        sizes.push_back((uint8_t)nPeople);
+        totalPeople += nPeople;
     }
 
-    if (m_families.empty()) {
+    if (sizes.empty()) {
         if (errorOut) *errorOut = "No rows parsed from CSV.";
         return false;
     }
+    m_ids.swap(ids);
+    m_sizes.swap(sizes);
+    m_choices.swap(choices);
+    m_totalPeople = totalPeople;
     return true;
 }
+
+bool ProblemData::saveSubmissionCsv(const QString& path,
+                                    const std::vector<int>& assignment,
+                                    QString* errorOut) const
+{
+    // Written to a temporary and renamed, so an existing file is never
+    // left half-written.
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (errorOut) *errorOut = "Cannot write: " + path;
+        return false;
+    }
+    f.write(submissionCsv(assignment));
+    if (!f.commit()) {
+        if (errorOut) *errorOut = "Cannot write: " + path + " (" + f.errorString() + ")";
+        return false;
+    }
+    return true;
+}
+
+uint64_t ProblemData::checksum() const
+{
+    uint64_t h = 1469598103934665603ull;
+    auto add = [&](uint32_t v) {
+        for (int b = 0; b < 4; ++b) {
+            h ^= (v >> (8 * b)) & 0xFF;
+            h *= 1099511628211ull;
+        }
+    };
+    add((uint32_t)familyCount());
+    for (int i = 0; i < familyCount(); ++i) {
+        add((uint32_t)m_ids[i]);
+        add(m_sizes[i]);
+        for (int r = 0; r < kChoices; ++r) add(choice(i, r));
+    }
+    return h;
+}
+
+QByteArray ProblemData::submissionCsv(const std::vector<int>& assignment) const
+{
+    QByteArray out;
+    out.reserve(24 + familyCount() * 10);
+    out += "family_id,assigned_day\n";
+    for (int i = 0; i < familyCount(); ++i) {
+        out += QByteArray::number(m_ids[i]);
+        out += ',';
+        out += QByteArray::number(assignment[i]);
+        out += '\n';
+    }
+    return out;
+}
@@ -1,23 +1,39 @@
 #pragma once
-#include <array>
+#include <cstdint>
 #include <vector>
+#include <QByteArray>
 #include <QString>
 
-struct Family {
-    int id = 0;
-    int nPeople = 0;
-    std::array<int, 10> choices{};
-};
-
+// Family data is stored as structure-of-arrays: the solver only touches the
+// one-byte sizes and the 10-byte choice rows, and ids are kept apart because
+// they are only needed when reading or writing submissions.
 class ProblemData {
 public:
+    static constexpr int kChoices = 10;
+    static constexpr int kMaxFamilySize = 255;
+
     bool loadFamilyCsv(const QString& path, QString* errorOut = nullptr);
+    bool saveSubmissionCsv(const QString& path, const std::vector<int>& assignment,
+                           QString* errorOut = nullptr) const;
+    QByteArray submissionCsv(const std::vector<int>& assignment) const;
+    // FNV-1a of ids, sizes and choices; equal data gives equal checksums.
+    uint64_t checksum() const;
 
-    int familyCount() const { return static_cast<int>(m_families.size()); }
-    const std::vector<Family>& families() const { return m_families; }
+    int familyCount() const { return static_cast<int>(m_sizes.size()); }
     int totalPeople() const { return m_totalPeople; }
 
+    int familyId(int i) const { return m_ids[i]; }
+    int familySize(int i) const { return m_sizes[i]; }
+    // Days of choices 0..9 of family i.
+    const uint8_t* choices(int i) const { return &m_choices[(size_t)i * kChoices]; }
+    int choice(int i, int rank) const { return m_choices[(size_t)i * kChoices + rank]; }
+
+    const std::vector<int>& familyIds() const { return m_ids; }
+    const std::vector<uint8_t>& familySizes() const { return m_sizes; }
+
 private:
-    std::vector<Family> m_families;
+    std::vector<int> m_ids;
+    std::vector<uint8_t> m_sizes;
+    std::vector<uint8_t> m_choices;   // familyCount() rows of kChoices days
     int m_totalPeople = 0;
 };
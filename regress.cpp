@@ -0,0 +1,160 @@
+#include "regress.h"
+#include "seedstream.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSaveFile>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const char* const kHeader = "seed,iterations,polish,final_cost,trajectory,moves_per_sec";
+
+uint64_t mix(uint64_t h, uint64_t v)
+{
+    return splitMix64(h ^ v);
+}
+
+// Costs are hashed at 1e-3 so a reordered floating-point sum in CostModel
+// does not count as a different trajectory; a different accepted move does.
+uint64_t quantize(double cost)
+{
+    return (uint64_t)std::llround(cost * 1000.0);
+}
+
+} // namespace
+
+RegressionRunner::RegressionRunner(const ProblemData& data, const CostModel& cost, int threads)
+    : m_data(data), m_cost(cost), m_threads(threads)
+{}
+
+RegressRun RegressionRunner::run(uint32_t seed, int iterations, bool polish) const
+{
+    RegressRun r;
+    r.seed = seed;
+    r.iterations = iterations;
+    r.polish = polish;
+
+    SolverParams params;
+    params.maxIterations = iterations;
+    params.reportEvery = std::max(1, iterations / 100);
+    params.seed = seed;
+    params.polish = polish;
+    params.threads = m_threads;
+
+    uint64_t h = seed;
+    std::vector<int> best;
+    SolverWorker worker(&m_data, &m_cost, QVector<int>(), params);
+    QObject::connect(&worker, &SolverWorker::progress,
+                     [&](int iter, double currentCost, double bestCost, QVector<int>) {
+                         h = mix(h, (uint64_t)iter);
+                         h = mix(h, quantize(currentCost));
+                         h = mix(h, quantize(bestCost));
+                     });
+    QObject::connect(&worker, &SolverWorker::finished, [&](QVector<int> a, double bestCost) {
+        best.assign(a.begin(), a.end());
+        r.finalCost = bestCost;
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    worker.run();
+    const double seconds = timer.nsecsElapsed() * 1e-9;
+
+    r.trajectory = mix(h, ZobristTable(m_data.familyCount()).hash(best));
+    r.movesPerSecond = seconds > 0.0 ? iterations / seconds : 0.0;
+    return r;
+}
+
+std::vector<RegressCheck> RegressionRunner::check(const RegressBaseline& baseline,
+                                                  double rateTolerance, double minRate) const
+{
+    std::vector<RegressCheck> out;
+    for (const RegressRun& expected : baseline.runs) {
+        RegressCheck c;
+        c.expected = expected;
+        c.actual = run(expected.seed, expected.iterations, expected.polish);
+        c.rateFloor = minRate > 0.0 ? minRate : expected.movesPerSecond * (1.0 - rateTolerance);
+        c.costOk = std::abs(c.actual.finalCost - expected.finalCost) <= 1e-3;
+        c.trajectoryOk = c.actual.trajectory == expected.trajectory;
+        c.rateOk = c.actual.movesPerSecond >= c.rateFloor;
+        out.push_back(c);
+    }
+    return out;
+}
+
+bool RegressionRunner::loadBaseline(const QString& path, RegressBaseline& out, QString* errorOut)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (errorOut) *errorOut = "Cannot open file: " + path;
+        return false;
+    }
+
+    RegressBaseline b;
+    bool haveData = false;
+    int lineNo = 0;
+    QTextStream in(&f);
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        ++lineNo;
+        if (line.isEmpty() || line == kHeader) continue;
+
+        bool ok = false;
+        if (line.startsWith("# data ")) {
+            b.dataChecksum = line.mid(7).toULongLong(&ok, 16);
+            haveData = ok;
+        } else if (!line.startsWith('#')) {
+            const QStringList parts = line.split(',');
+            RegressRun r;
+            bool okFields[6] = {};
+            if (parts.size() == 6) {
+                r.seed = parts[0].toUInt(&okFields[0]);
+                r.iterations = parts[1].toInt(&okFields[1]);
+                r.polish = parts[2].toInt(&okFields[2]) != 0;
+                r.finalCost = parts[3].toDouble(&okFields[3]);
+                r.trajectory = parts[4].toULongLong(&okFields[4], 16);
+                r.movesPerSecond = parts[5].toDouble(&okFields[5]);
+                ok = std::all_of(okFields, okFields + 6, [](bool v) { return v; }) && r.iterations > 0;
+            }
+            if (ok) b.runs.push_back(r);
+        } else {
+            ok = true;
+        }
+        if (!ok) {
+            if (errorOut) *errorOut = QString("Malformed baseline line %1: %2").arg(lineNo).arg(path);
+            return false;
+        }
+    }
+
+    if (!haveData || b.runs.empty()) {
+        if (errorOut) *errorOut = "Not a regression baseline: " + path;
+        return false;
+    }
+    out = b;
+    return true;
+}
+
+bool RegressionRunner::saveBaseline(const QString& path, const RegressBaseline& baseline, QString* errorOut)
+{
+    QByteArray text;
+    text += "# data " + QByteArray::number((qulonglong)baseline.dataChecksum, 16) + "\n";
+    text += kHeader;
+    text += "\n";
+    for (const RegressRun& r : baseline.runs) {
+        text += QByteArray::number(r.seed) + "," + QByteArray::number(r.iterations) + ","
+              + QByteArray::number(r.polish ? 1 : 0) + ","
+              + QByteArray::number(r.finalCost, 'f', 6) + ","
+              + QByteArray::number((qulonglong)r.trajectory, 16) + ","
+              + QByteArray::number(r.movesPerSecond, 'f', 0) + "\n";
+    }
+
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Text) || f.write(text) != text.size() || !f.commit()) {
+        if (errorOut) *errorOut = "Cannot write: " + path;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "problemdata.h"
+#include "costmodel.h"
+#include "solver.h"
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+// One fixed-seed annealing run, reduced to what a regression baseline keeps.
+struct RegressRun {
+    uint32_t seed = 0;
+    int iterations = 0;
+    bool polish = false;
+    double finalCost = 0.0;
+    uint64_t trajectory = 0;     // hash of every progress report and of the final best
+    double movesPerSecond = 0.0; // annealing iterations / wall time of the whole run
+};
+
+struct RegressBaseline {
+    uint64_t dataChecksum = 0;   // ProblemData::checksum of the reference data
+    std::vector<RegressRun> runs;
+};
+
+struct RegressCheck {
+    RegressRun expected;
+    RegressRun actual;
+    double rateFloor = 0.0;
+    bool costOk = false;
+    bool trajectoryOk = false;
+    bool rateOk = false;
+
+    bool passed() const { return costOk && trajectoryOk && rateOk; }
+};
+
+// Replays fixed-seed SolverWorker runs against a baseline. A change that only
+// makes CostModel or the solver faster must reproduce every report of the
+// baseline runs exactly; the throughput floor catches slowdowns. Runs are
+// executed one after another so their timings do not disturb each other.
+class RegressionRunner {
+public:
+    // `threads` only affects parallel phases (polish); results must not depend on it.
+    RegressionRunner(const ProblemData& data, const CostModel& cost, int threads = 1);
+
+    RegressRun run(uint32_t seed, int iterations, bool polish) const;
+    // A run passes if it reproduces the baseline's cost and trajectory and
+    // reaches (1 - rateTolerance) of its moves/sec, or `minRate` when positive.
+    std::vector<RegressCheck> check(const RegressBaseline& baseline,
+                                    double rateTolerance, double minRate = 0.0) const;
+
+    static bool loadBaseline(const QString& path, RegressBaseline& out, QString* errorOut = nullptr);
+    static bool saveBaseline(const QString& path, const RegressBaseline& baseline, QString* errorOut = nullptr);
+
+private:
+    const ProblemData& m_data;
+    const CostModel& m_cost;
+    int m_threads = 1;
+};
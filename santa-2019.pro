@@ -2,17 +2,44 @@ QT += core gui widgets charts
 CONFIG += c++17
 
 SOURCES += \
+    annealstate.cpp \
+    cli.cpp \
     costmodel.cpp \
+    elitepool.cpp \
+    genetic.cpp \
+    island.cpp \
     main.cpp \
     mainwindow.cpp \
+    polisher.cpp \
     problemdata.cpp \
-    solver.cpp
+    regress.cpp \
+    scorer.cpp \
+    snapshotwriter.cpp \
+    solver.cpp \
+    tuner.cpp \
+    zobrist.cpp
 
 HEADERS += \
+    annealstate.h \
+    cli.h \
     costmodel.h \
+    elitepool.h \
+    genetic.h \
+    island.h \
     mainwindow.h \
+    parallel.h \
+    polisher.h \
     problemdata.h \
-    solver.h
+    regress.h \
+    scorer.h \
+    seedstream.h \
+    snapshotwriter.h \
+    solver.h \
+    tuner.h \
+    zobrist.h
+
+# shm_open lives in librt on older glibc
+unix:!macx: LIBS += -lrt
 
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
@@ -0,0 +1,216 @@
+#include "scorer.h"
+#include "parallel.h"
+#include "snapshotwriter.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Parses a non-negative decimal integer at p, advancing it.
+bool parseInt(const char*& p, const char* end, int& out)
+{
+    if (p == end || *p < '0' || *p > '9') return false;
+    int v = 0;
+    while (p != end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (*p - '0');
+        if (v > 100000000) return false;
+        ++p;
+    }
+    out = v;
+    return true;
+}
+
+} // namespace
+
+SubmissionScorer::SubmissionScorer(const ProblemData& data, const CostModel& cost)
+    : m_data(data), m_cost(cost)
+{
+    int maxId = -1;
+    for (int id : m_data.familyIds()) maxId = std::max(maxId, id);
+    m_indexOfId.assign((size_t)maxId + 1, -1);
+    for (int i = 0; i < m_data.familyCount(); ++i) {
+        const int id = m_data.familyId(i);
+        if (id >= 0) m_indexOfId[id] = i;
+    }
+}
+
+int SubmissionScorer::choiceRank(int familyIndex, int day) const
+{
+    const uint8_t* choices = m_data.choices(familyIndex);
+    for (int r = 0; r < ProblemData::kChoices; ++r)
+        if (choices[r] == day) return r;
+    return ProblemData::kChoices;
+}
+
+bool SubmissionScorer::parse(const char* text, size_t size,
+                             std::vector<int>& assignment, QString* errorOut) const
+{
+    const int F = m_data.familyCount();
+    assignment.assign((size_t)F, 0);
+
+    const char* p = text;
+    const char* end = text + size;
+    int line = 0;
+    int seen = 0;
+
+    while (p != end) {
+        ++line;
+        const char* eol = static_cast<const char*>(memchr(p, '\n', (size_t)(end - p)));
+        if (!eol) eol = end;
+
+        const char* q = p;
+        while (q != eol && isSpace(*q)) ++q;
+        if (q == eol) {
+            p = eol == end ? end : eol + 1;
+            continue;
+        }
+        // Header row ("family_id,assigned_day").
+        if (line == 1 && (*q < '0' || *q > '9')) {
+            p = eol == end ? end : eol + 1;
+            continue;
+        }
+
+        int id = 0, day = 0;
+        bool ok = parseInt(q, eol, id);
+        while (ok && q != eol && isSpace(*q)) ++q;
+        ok = ok && q != eol && *q++ == ',';
+        while (ok && q != eol && isSpace(*q)) ++q;
+        ok = ok && parseInt(q, eol, day);
+        while (ok && q != eol && isSpace(*q)) ++q;
+        if (!ok || q != eol) {
+            if (errorOut) *errorOut = QString("Line %1: expected family_id,assigned_day").arg(line);
+            return false;
+        }
+
+        const int f = id < (int)m_indexOfId.size() ? m_indexOfId[id] : -1;
+        if (f < 0) {
+            if (errorOut) *errorOut = QString("Line %1: unknown family id %2").arg(line).arg(id);
+            return false;
+        }
+        if (day < 1 || day > 100) {
+            if (errorOut) *errorOut = QString("Line %1: day %2 out of range").arg(line).arg(day);
+            return false;
+        }
+        if (assignment[f] != 0) {
+            if (errorOut) *errorOut = QString("Line %1: family %2 assigned twice").arg(line).arg(id);
+            return false;
+        }
+        assignment[f] = day;
+        ++seen;
+
+        p = eol == end ? end : eol + 1;
+    }
+
+    if (seen != F) {
+        if (errorOut) *errorOut = QString("%1 of %2 families assigned").arg(seen).arg(F);
+        return false;
+    }
+    return true;
+}
+
+bool SubmissionScorer::readCsv(const QString& path, std::vector<int>& assignment, QString* errorOut) const
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = "Cannot open file";
+        return false;
+    }
+    const qint64 size = f.size();
+    if (size <= 0) {
+        if (errorOut) *errorOut = "Empty file";
+        return false;
+    }
+    uchar* mapped = f.map(0, size);
+    if (!mapped) {
+        if (errorOut) *errorOut = "Cannot map file: " + f.errorString();
+        return false;
+    }
+
+    const bool parsed = parse(reinterpret_cast<const char*>(mapped), (size_t)size, assignment, errorOut);
+    f.unmap(mapped);
+    return parsed;
+}
+
+SubmissionScore SubmissionScorer::score(const QString& path) const
+{
+    SubmissionScore s;
+    s.path = path;
+
+    // Binary snapshots carry the cost they were written with; a different
+    // cost on re-scoring means the file does not round-trip (or belongs to
+    // other family data).
+    const bool binary = path.endsWith(".bin", Qt::CaseInsensitive);
+    double storedCost = 0.0;
+    std::vector<int> assignment;
+    if (binary) {
+        if (!SnapshotWriter::readBinary(path, assignment, &storedCost, &s.error)) return s;
+        if ((int)assignment.size() != m_data.familyCount()) {
+            s.error = QString("%1 of %2 families in snapshot").arg((int)assignment.size()).arg(m_data.familyCount());
+            return s;
+        }
+    } else if (!readCsv(path, assignment, &s.error)) {
+        return s;
+    }
+
+    std::vector<int> occ;
+    double pref = 0.0;
+    s.total = m_cost.totalCost(assignment, &occ, &pref, &s.accounting);
+    s.preference = (int64_t)pref;
+    std::copy(occ.begin(), occ.end(), s.occupancy.begin());
+
+    for (int i = 0; i < m_data.familyCount(); ++i)
+        ++s.rankHistogram[choiceRank(i, assignment[i])];
+
+    s.minOccupancy = *std::min_element(s.occupancy.begin() + 1, s.occupancy.end());
+    s.maxOccupancy = *std::max_element(s.occupancy.begin() + 1, s.occupancy.end());
+    for (int d = 1; d <= 100; ++d) {
+        const int n = s.occupancy[d];
+        if (n < 125 || n > 300) {
+            s.error = QString("Day %1 has %2 people").arg(d).arg(n);
+            return s;
+        }
+    }
+
+    if (binary && std::abs(storedCost - s.total) > kRoundTripTolerance) {
+        s.error = QString("Stored cost %1 does not match %2").arg(storedCost, 0, 'f', 4).arg(s.total, 0, 'f', 4);
+        return s;
+    }
+
+    s.valid = true;
+    return s;
+}
+
+std::vector<SubmissionScore> SubmissionScorer::scoreAll(const QStringList& paths, int threads) const
+{
+    std::vector<SubmissionScore> out((size_t)paths.size());
+    parallelFor((int)paths.size(), threads, [&](int i) { out[i] = score(paths[i]); });
+
+    std::stable_sort(out.begin(), out.end(), [](const SubmissionScore& a, const SubmissionScore& b) {
+        if (a.valid != b.valid) return a.valid;
+        if (a.valid && a.total != b.total) return a.total < b.total;
+        return a.path < b.path;
+    });
+    return out;
+}
+
+QStringList SubmissionScorer::expandPaths(const QStringList& args)
+{
+    QStringList paths;
+    for (const QString& arg : args) {
+        const QFileInfo info(arg);
+        if (!info.isDir()) {
+            paths << arg;
+            continue;
+        }
+        const QDir dir(arg);
+        for (const QString& name : dir.entryList({ "*.csv", "*.bin" }, QDir::Files, QDir::Name))
+            paths << dir.filePath(name);
+    }
+    return paths;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "problemdata.h"
+#include "costmodel.h"
+#include <QString>
+#include <QStringList>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+struct SubmissionScore {
+    QString path;
+    bool valid = false;
+    QString error;                       // why the submission is invalid
+
+    double total = 0.0;
+    int64_t preference = 0;
+    double accounting = 0.0;
+
+    std::array<int, 11> rankHistogram{}; // families on choice 0..9, [10] = none
+    std::array<int, 101> occupancy{};    // people per day, index 1..100
+    int minOccupancy = 0;
+    int maxOccupancy = 0;
+};
+
+// Scores submission CSVs without the GUI. Files are mapped into memory and
+// parsed in place; every family of `data` must appear exactly once and every
+// day must hold 125..300 people for a submission to be valid. Paths ending in
+// .bin are read as SnapshotWriter snapshots and are also invalid when their
+// stored cost differs from the re-scored one.
+class SubmissionScorer {
+public:
+    SubmissionScorer(const ProblemData& data, const CostModel& cost);
+
+    SubmissionScore score(const QString& path) const;
+    // Scores all paths on `threads` workers (0 = all cores). Valid results
+    // come first by total cost, invalid ones after them by path.
+    std::vector<SubmissionScore> scoreAll(const QStringList& paths, int threads = 0) const;
+
+    // Expands directories to the *.csv and *.bin files they contain.
+    static QStringList expandPaths(const QStringList& args);
+
+private:
+    // Snapshots written during a run store the tracked best cost, which may
+    // differ from the exact total by rounding only.
+    static constexpr double kRoundTripTolerance = 1e-3;
+
+    const ProblemData& m_data;
+    const CostModel& m_cost;
+    std::vector<int> m_indexOfId;        // family id -> family index, -1 if unknown
+
+    bool readCsv(const QString& path, std::vector<int>& assignment, QString* errorOut) const;
+    bool parse(const char* text, size_t size, std::vector<int>& assignment, QString* errorOut) const;
+    int choiceRank(int familyIndex, int day) const;
+};
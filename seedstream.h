@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+
+// Seeds for parallel workers are derived from the run's master seed, never
+// by adding small offsets to it: neighbouring mt19937 seeds give correlated
+// streams, and master + offset collides across workers (seed 42 worker 1 ==
+// seed 43 worker 0). Each (stream, a, b) gets its own SplitMix64 output, so
+// a run is reproducible from the master seed alone, whatever the thread
+// count or scheduling.
+enum class SeedStream : uint64_t {
+    Island = 1,      // a = island id
+    GeneticInit,     // a = individual
+    GeneticSelect,   // parent selection on the coordinating thread
+    GeneticChild,    // a = generation, b = child
+    TuneSampling,    // configuration sampling
+    TuneReplica,     // a = replica
+};
+
+inline uint64_t splitMix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+inline uint32_t deriveSeed(uint32_t master, SeedStream stream, uint64_t a = 0, uint64_t b = 0)
+{
+    uint64_t h = splitMix64(master);
+    h = splitMix64(h ^ (uint64_t)stream);
+    h = splitMix64(h ^ a);
+    h = splitMix64(h ^ b);
+    return (uint32_t)(h >> 32);
+}
@@ -0,0 +1,189 @@
+#include "snapshotwriter.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <cstring>
+
+namespace {
+
+// Binary snapshot: header, one byte per family (its day), FNV-1a of the days.
+// Fields are in host byte order; snapshots are meant for the machine that
+// wrote them.
+constexpr uint32_t kMagic = 0x534E5431; // "SNT1"
+constexpr uint32_t kVersion = 1;
+
+struct BinaryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t families;
+    uint32_t reserved;
+    double cost;
+};
+
+uint64_t fnv1a(const uint8_t* p, size_t n)
+{
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+} // namespace
+
+QString SnapshotPolicy::binaryPathOrDefault() const
+{
+    return binaryPath.isEmpty() ? SnapshotWriter::binaryPathFor(csvPath) : binaryPath;
+}
+
+bool SnapshotPolicy::due(double best, double last, qint64 elapsedMs) const
+{
+    if (!(best < last)) return false;
+    const bool improved = minImprovement > 0.0 && best <= last - minImprovement;
+    const bool timed = intervalMs > 0 && elapsedMs >= intervalMs;
+    return improved || timed;
+}
+
+SnapshotWriter::SnapshotWriter(const ProblemData* data, QObject* parent)
+    : QObject(parent), m_data(data)
+{
+    m_thread = std::thread(&SnapshotWriter::loop, this);
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    // Pending snapshots are written before the thread exits.
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+void SnapshotWriter::submit(const std::vector<int>& assignment, double cost,
+                            const QString& csvPath, const QString& binaryPath)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Job* job = nullptr;
+        for (Job& j : m_pending)
+            if (j.csvPath == csvPath) job = &j;
+        if (!job) {
+            m_pending.emplace_back();
+            job = &m_pending.back();
+            job->csvPath = csvPath;
+        }
+        job->assignment = assignment;
+        job->cost = cost;
+        job->binaryPath = binaryPath;
+    }
+    m_wake.notify_one();
+}
+
+void SnapshotWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [&] { return m_pending.empty() && !m_busy; });
+}
+
+void SnapshotWriter::loop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [&] { return m_quit || !m_pending.empty(); });
+        if (m_pending.empty()) return; // quitting with nothing left
+
+        std::vector<Job> jobs;
+        jobs.swap(m_pending);
+        m_busy = true;
+        lock.unlock();
+
+        for (const Job& job : jobs) {
+            QString e;
+            if (write(job, &e)) emit written(job.csvPath, job.cost);
+            else emit failed(job.csvPath, e);
+        }
+
+        lock.lock();
+        m_busy = false;
+        m_idle.notify_all();
+    }
+}
+
+bool SnapshotWriter::write(const Job& job, QString* errorOut) const
+{
+    if (!m_data->saveSubmissionCsv(job.csvPath, job.assignment, errorOut)) return false;
+    if (!job.binaryPath.isEmpty() && !writeBinary(job, errorOut)) return false;
+    return true;
+}
+
+bool SnapshotWriter::writeBinary(const Job& job, QString* errorOut) const
+{
+    const size_t F = job.assignment.size();
+    QByteArray bytes((int)(sizeof(BinaryHeader) + F + sizeof(uint64_t)), '\0');
+    char* p = bytes.data();
+
+    const BinaryHeader h{ kMagic, kVersion, (uint32_t)F, 0, job.cost };
+    std::memcpy(p, &h, sizeof(h));
+    uint8_t* days = reinterpret_cast<uint8_t*>(p + sizeof(h));
+    for (size_t i = 0; i < F; ++i) days[i] = (uint8_t)job.assignment[i];
+    const uint64_t sum = fnv1a(days, F);
+    std::memcpy(p + sizeof(h) + F, &sum, sizeof(sum));
+
+    QSaveFile f(job.binaryPath);
+    if (!f.open(QIODevice::WriteOnly) || f.write(bytes) != bytes.size() || !f.commit()) {
+        if (errorOut) *errorOut = "Cannot write: " + job.binaryPath;
+        return false;
+    }
+    return true;
+}
+
+QString SnapshotWriter::binaryPathFor(const QString& csvPath)
+{
+    const QFileInfo info(csvPath);
+    return info.dir().filePath(info.completeBaseName() + ".bin");
+}
+
+bool SnapshotWriter::readBinary(const QString& path, std::vector<int>& assignment,
+                                double* cost, QString* errorOut)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = "Cannot open file: " + path;
+        return false;
+    }
+    const QByteArray bytes = f.readAll();
+
+    BinaryHeader h{};
+    if ((size_t)bytes.size() < sizeof(h)) {
+        if (errorOut) *errorOut = "Truncated snapshot: " + path;
+        return false;
+    }
+    std::memcpy(&h, bytes.constData(), sizeof(h));
+    if (h.magic != kMagic || h.version != kVersion
+        || (size_t)bytes.size() != sizeof(h) + h.families + sizeof(uint64_t)) {
+        if (errorOut) *errorOut = "Not a snapshot file: " + path;
+        return false;
+    }
+
+    const uint8_t* days = reinterpret_cast<const uint8_t*>(bytes.constData() + sizeof(h));
+    uint64_t sum = 0;
+    std::memcpy(&sum, days + h.families, sizeof(sum));
+    if (sum != fnv1a(days, h.families)) {
+        if (errorOut) *errorOut = "Corrupt snapshot: " + path;
+        return false;
+    }
+
+    assignment.assign(days, days + h.families);
+    for (int d : assignment) {
+        if (d < 1 || d > 100) {
+            if (errorOut) *errorOut = "Corrupt snapshot: " + path;
+            return false;
+        }
+    }
+    if (cost) *cost = h.cost;
+    return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <QObject>
+#include <QString>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "problemdata.h"
+
+// When a running solver hands its best assignment to a SnapshotWriter.
+struct SnapshotPolicy {
+    QString csvPath = "submission.csv";
+    QString binaryPath;            // empty = binaryPathFor(csvPath)
+    int intervalMs = 30000;        // snapshot a better best at most this often (0 = off)
+    double minImprovement = 0.0;   // also snapshot once the best improves this much (0 = off)
+
+    QString binaryPathOrDefault() const;
+    // Whether a solver whose best is `best`, last snapshotted at `last`
+    // `elapsedMs` ago, should snapshot now.
+    bool due(double best, double last, qint64 elapsedMs) const;
+};
+
+// Persists assignments on its own thread. submit() only copies the
+// assignment under a short lock; formatting and file I/O happen on the
+// writer thread. Both files are written to a temporary and renamed into
+// place, so a crash leaves the previous snapshot intact. A snapshot still
+// waiting for the same CSV path is replaced, never queued behind.
+class SnapshotWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SnapshotWriter(const ProblemData* data, QObject* parent = nullptr);
+    ~SnapshotWriter() override;
+
+    // An empty binaryPath writes the CSV only.
+    void submit(const std::vector<int>& assignment, double cost,
+                const QString& csvPath, const QString& binaryPath = QString());
+    // Blocks until everything submitted so far is on disk.
+    void flush();
+
+    // "dir/name.csv" -> "dir/name.bin".
+    static QString binaryPathFor(const QString& csvPath);
+    static bool readBinary(const QString& path, std::vector<int>& assignment,
+                           double* cost = nullptr, QString* errorOut = nullptr);
+
+signals:
+    void written(QString csvPath, double cost);
+    void failed(QString csvPath, QString error);
+
+private:
+    struct Job {
+        std::vector<int> assignment;
+        double cost = 0.0;
+        QString csvPath;
+        QString binaryPath;
+    };
+
+    const ProblemData* m_data = nullptr;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::vector<Job> m_pending;
+    bool m_busy = false;
+    bool m_quit = false;
+    std::thread m_thread;
+
+    void loop();
+    bool write(const Job& job, QString* errorOut) const;
+    bool writeBinary(const Job& job, QString* errorOut) const;
+};
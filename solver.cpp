@@ -1,6 +1,9 @@
 #include "solver.h"
+#include "polisher.h"
+#include <QElapsedTimer>
 #include <cmath>
 #include <algorithm>
+#include <memory>
 
 SolverWorker::SolverWorker(const ProblemData* data,
                            const CostModel* cost,
@@ -14,26 +17,78 @@ void SolverWorker::stop()
     m_stop.store(true);
 }
 
-std::vector<int> SolverWorker::makeFeasibleInitial(std::mt19937& rng) const
+void SolverWorker::setMigration(IslandExchange* exchange, int island, const MigrationParams& migration)
 {
-    const int F = m_data->familyCount();
+    m_exchange = exchange;
+    m_island = island;
+    m_migration = migration;
+}
+
+void SolverWorker::setSnapshots(SnapshotWriter* writer, const SnapshotPolicy& policy)
+{
+    m_snapshots = writer;
+    m_snapshotPolicy = policy;
+}
+
+bool SolverWorker::importMigrant(std::mt19937& rng, Migrant& out) const
+{
+    const int n = m_exchange->slotCount();
+    if (n < 2) return false;
+
+    // Slots of dead processes are skipped: they hold either a crashed peer's
+    // last state or a leftover from an earlier campaign.
+    auto readLive = [&](int s, Migrant& m) { return m_exchange->alive(s) && m_exchange->read(s, m); };
+
+    switch (m_migration.policy) {
+    case MigrationPolicy::Ring:
+        return readLive((m_island + n - 1) % n, out);
+    case MigrationPolicy::Random: {
+        std::uniform_int_distribution<int> pick(0, n - 2);
+        int s = pick(rng);
+        if (s >= m_island) ++s;
+        return readLive(s, out);
+    }
+    case MigrationPolicy::Best:
+    default: {
+        // Slots are scanned in order and only a strictly better cost wins, so
+        // ties go to the lowest slot.
+        bool found = false;
+        Migrant m;
+        for (int s = 0; s < n; ++s) {
+            if (s == m_island || !readLive(s, m)) continue;
+            if (!found || m.cost < out.cost) {
+                out = m;
+                found = true;
+            }
+        }
+        return found;
+    }
+    }
+}
+
+std::vector<int> makeFeasibleAssignment(const ProblemData* data,
+                                        const CostModel* cost,
+                                        std::mt19937& rng)
+{
+    const int F = data->familyCount();
     std::vector<int> assign(F, 1);
     std::vector<int> occ(101, 0);
     std::vector<int> order(F);
     for (int i = 0; i < F; ++i) order[i] = i;
     std::sort(order.begin(), order.end(), [&](int a, int b){
-        return m_data->families()[a].nPeople > m_data->families()[b].nPeople;
+        return data->familySize(a) > data->familySize(b);
     });
 
     for (int idx : order) {
-        const auto& fam = m_data->families()[idx];
+        const int n = data->familySize(idx);
+        const uint8_t* choices = data->choices(idx);
         bool placed = false;
 
-        for (int r = 0; r < 10; ++r) {
-            int d = fam.choices[r];
-            if (occ[d] + fam.nPeople <= 300) {
+        for (int r = 0; r < ProblemData::kChoices; ++r) {
+            int d = choices[r];
+            if (occ[d] + n <= 300) {
                 assign[idx] = d;
-                occ[d] += fam.nPeople;
+                occ[d] += n;
                 placed = true;
                 break;
             }
@@ -42,13 +97,13 @@ std::vector<int> SolverWorker::makeFeasibleInitial(std::mt19937& rng) const
             int bestDay = 1;
             int bestOcc = 1e9;
             for (int d = 1; d <= 100; ++d) {
-                if (occ[d] + fam.nPeople <= 300 && occ[d] < bestOcc) {
+                if (occ[d] + n <= 300 && occ[d] < bestOcc) {
                     bestOcc = occ[d];
                     bestDay = d;
                 }
             }
             assign[idx] = bestDay;
-            occ[bestDay] += fam.nPeople;
+            occ[bestDay] += n;
         }
     }
 
@@ -72,6 +127,8 @@ std::vector<int> SolverWorker::makeFeasibleInitial(std::mt19937& rng) const
         posInDay[fam] = (int)dayToFamilies[day].size();
         dayToFamilies[day].push_back(fam);
     };
+    AccountingTracker accounting;
+    accounting.reset(occ);
     for (int pass = 0; pass < 20000; ++pass) {
         int worstDay = -1;
         int minOcc = 1e9;
@@ -98,53 +155,161 @@ std::vector<int> SolverWorker::makeFeasibleInitial(std::mt19937& rng) const
 
         double bestDelta = 1e100;
         int bestFam = -1;
+        AccountingTerms bestTerms;
 
         for (int t = 0; t < 60; ++t) {
             int famIdx = donorList[pick(rng)];
-            const int n = m_data->families()[famIdx].nPeople;
+            const int n = data->familySize(famIdx);
 
             if (occ[donorDay] - n < 125) continue;
             if (occ[worstDay] + n > 300) continue;
 
             const double dPref =
-                (double)m_cost->preferenceCost(famIdx, worstDay) -
-                (double)m_cost->preferenceCost(famIdx, donorDay);
+                (double)cost->preferenceCost(famIdx, worstDay) -
+                (double)cost->preferenceCost(famIdx, donorDay);
 
+            AccountingTerms terms;
             const double dAcc =
-                m_cost->deltaAccounting2(occ, donorDay, -n, worstDay, +n);
+                accounting.delta(occ, donorDay, -n, worstDay, +n, &terms);
 
             double delta = dPref + dAcc;
             if (delta < bestDelta) {
                 bestDelta = delta;
                 bestFam = famIdx;
+                bestTerms = terms;
             }
         }
 
         if (bestFam == -1) {
             continue;
         }
-        const int n = m_data->families()[bestFam].nPeople;
+        const int n = data->familySize(bestFam);
         removeFromDay(bestFam, donorDay);
         occ[donorDay] -= n;
         assign[bestFam] = worstDay;
         occ[worstDay] += n;
+        accounting.commit(bestTerms);
         addToDay(bestFam, worstDay);
     }
 
     return assign;
 }
 
+// Day drawn with probability proportional to its accounting term, so shaping
+// concentrates where the profile is rough.
+static int sampleDayByAccounting(const AccountingTracker& accounting, std::mt19937& rng)
+{
+    const double total = accounting.total();
+    if (!(total > 0.0)) return std::uniform_int_distribution<int>(1, 100)(rng);
+    double r = std::uniform_real_distribution<double>(0.0, total)(rng);
+    for (int d = 1; d < 100; ++d) {
+        r -= accounting.dayCost(d);
+        if (r < 0.0) return d;
+    }
+    return 100;
+}
+
+bool annealStep(AnnealState& state, std::mt19937& rng, double T,
+                const MoveMix& mix, RecencyTable* tabu)
+{
+    const ProblemData* data = state.data();
+    const std::vector<int>& current = state.assignment();
+
+    std::uniform_int_distribution<int> famDist(0, data->familyCount() - 1);
+    std::uniform_int_distribution<int> dayDist(1, 100);
+    std::uniform_real_distribution<double> uni(0.0, 1.0);
+
+    Proposal prop;
+
+    if (mix.shapeProbability > 0.0 && uni(rng) < mix.shapeProbability) {
+        // Day d's term depends on N_d and N_d+1, so the partner is usually
+        // the next day, otherwise a nearby one.
+        const int a = sampleDayByAccounting(state.accounting(), rng);
+        int b = a + 1;
+        if (a == 100 || uni(rng) < 0.5) {
+            const int offset = std::uniform_int_distribution<int>(1, 3)(rng);
+            b = uni(rng) < 0.5 ? a - offset : a + offset;
+            b = std::clamp(b, 1, 100);
+            if (b == a) b = a == 100 ? 99 : a + 1;
+        }
+        if (!state.proposeShape(a, b, rng, prop)) return false;
+    } else if (uni(rng) >= mix.swapProbability) {
+        // MOVE
+        int f = famDist(rng);
+        int oldDay = current[f];
+
+        int newDay = oldDay;
+        if (uni(rng) < mix.choiceMoveProbability) {
+            int r = (int)(uni(rng) * mix.choiceRanks);
+            r = std::clamp(r, 0, mix.choiceRanks - 1);
+            newDay = data->choice(f, r);
+        } else {
+            newDay = dayDist(rng);
+        }
+        if (!state.proposeMove(f, newDay, prop)) return false;
+    } else {
+        int f1 = famDist(rng);
+        int f2 = famDist(rng);
+        if (!state.proposeSwap(f1, f2, prop)) return false;
+    }
+
+    const double delta = prop.delta;
+    // Without hashing every hash is 0, so the table would only see one state.
+    if (!state.hashing()) tabu = nullptr;
+    if (tabu && delta >= 0.0 && tabu->contains(state.hashAfter(prop))) return false;
+
+    bool accept = (delta < 0.0) || (uni(rng) < std::exp(-delta / std::max(1e-9, T)));
+    if (accept) {
+        state.commit(prop);
+        if (tabu) tabu->insert(state.hash());
+    }
+    return accept;
+}
+
+void annealBurst(AnnealState& state, std::mt19937& rng,
+                 int iterations, double t0, double t1,
+                 std::vector<int>& best, double& bestCost,
+                 const MoveMix& mix, const std::atomic_bool* stop)
+{
+    for (int iter = 1; iter <= iterations; ++iter) {
+        if (stop && (iter & 1023) == 0 && stop->load(std::memory_order_relaxed)) return;
+        const double a = (double)iter / std::max(1, iterations);
+        const double T = t0 * std::pow(t1 / t0, a);
+        if (annealStep(state, rng, T, mix) && state.cost() < bestCost) {
+            bestCost = state.cost();
+            best = state.assignment();
+        }
+    }
+}
+
 void SolverWorker::run()
 {
     m_stop.store(false);
     std::mt19937 rng(m_params.seed);
 
     emit log("Building initial feasible schedule...");
-    std::vector<int> current = makeFeasibleInitial(rng);
+    // The running cost is never accumulated from deltas: AnnealState keeps the
+    // preference cost as an exact integer and accounting cost as cached
+    // per-day terms, so the total is always derived from stored values.
+    AnnealState state(m_data, m_cost);
+    state.reset(makeFeasibleAssignment(m_data, m_cost, rng));
+
+    std::unique_ptr<ZobristTable> zobrist;
+    std::unique_ptr<RecencyTable> tabu;
+    if (m_params.tabuSize > 0 || m_exchange) {
+        zobrist = std::make_unique<ZobristTable>(m_data->familyCount());
+        state.setZobrist(zobrist.get());
+    }
+    if (m_params.tabuSize > 0) {
+        tabu = std::make_unique<RecencyTable>(m_params.tabuSize);
+        tabu->insert(state.hash());
+    }
+    RecencyTable imported(64);
+    if (m_params.oscillation)
+        state.setOscillation(true, m_params.penaltyWeight);
+    int infeasibleIters = 0;
 
-    std::vector<int> occ;
-    double pref = 0.0, acc = 0.0;
-    double currentCost = m_cost->totalCost(current, &occ, &pref, &acc);
+    const std::vector<int>& occ = state.occupancy();
     for (int d = 1; d <= 100; ++d) {
         if (occ[d] < 125 || occ[d] > 300) {
             emit log("WARNING: Initial schedule violated constraints (should not happen).");
@@ -152,33 +317,16 @@ void SolverWorker::run()
         }
     }
 
-    std::vector<int> best = current;
-    double bestCost = currentCost;
     const int F = m_data->familyCount();
-    std::vector<std::vector<int>> dayToFamilies(101);
-    std::vector<int> posInDay(F, 0);
-    for (int i = 0; i < F; ++i) {
-        int d = current[i];
-        posInDay[i] = (int)dayToFamilies[d].size();
-        dayToFamilies[d].push_back(i);
-    }
-
-    auto removeFromDay = [&](int fam, int day){
-        auto& v = dayToFamilies[day];
-        int p = posInDay[fam];
-        int last = v.back();
-        v[p] = last;
-        posInDay[last] = p;
-        v.pop_back();
-    };
-    auto addToDay = [&](int fam, int day){
-        posInDay[fam] = (int)dayToFamilies[day].size();
-        dayToFamilies[day].push_back(fam);
-    };
+    double currentCost = state.cost();
+    std::vector<int> best = state.assignment();
+    double bestCost = currentCost;
+    double maxDrift = 0.0;
 
-    std::uniform_int_distribution<int> famDist(0, F - 1);
-    std::uniform_int_distribution<int> dayDist(1, 100);
-    std::uniform_real_distribution<double> uni(0.0, 1.0);
+    const QString snapshotBinary = m_snapshotPolicy.binaryPathOrDefault();
+    double snapshotCost = bestCost;
+    QElapsedTimer snapshotTimer;
+    snapshotTimer.start();
 
     auto temperatureAt = [&](int iter) -> double {
         const double t0 = m_params.startTemp;
@@ -189,103 +337,76 @@ void SolverWorker::run()
 
     emit log("Starting simulated annealing...");
     for (int iter = 1; iter <= m_params.maxIterations && !m_stop.load(); ++iter) {
+        // Audit first so every iteration is covered whatever the step does.
+        if (m_params.auditEvery > 0 && iter % m_params.auditEvery == 0) {
+            const double exact = m_cost->totalCost(state.assignment());
+            const double drift = std::abs(currentCost - exact);
+            maxDrift = std::max(maxDrift, drift);
+            if (drift > AccountingTracker::kTolerance) {
+                emit log(QString("Cost drift %1 at iter %2, resyncing.")
+                             .arg(drift, 0, 'g', 6).arg(iter));
+            }
+            state.resync();
+            currentCost = state.cost();
+        }
 
         const double T = temperatureAt(iter);
-        const bool doSwap = (uni(rng) < 0.30);
-
-        double delta = 0.0;
-
-        if (!doSwap) {
-            // MOVE
-            int f = famDist(rng);
-            int oldDay = current[f];
-
-            int newDay = oldDay;
-            if (uni(rng) < 0.85) {
-                int r = (int)(uni(rng) * 10.0);
-                r = std::clamp(r, 0, 9);
-                newDay = m_data->families()[f].choices[r];
-            } else {
-                newDay = dayDist(rng);
+        if (annealStep(state, rng, T, m_params.moves, tabu.get())) {
+            currentCost = state.cost();
+            if (currentCost < bestCost && state.feasible()) {
+                bestCost = currentCost;
+                best = state.assignment();
             }
-            if (newDay == oldDay) continue;
-
-            const int n = m_data->families()[f].nPeople;
-            if (occ[oldDay] - n < 125) continue;
-            if (occ[newDay] + n > 300) continue;
+        }
 
-            const double dPref =
-                (double)m_cost->preferenceCost(f, newDay) -
-                (double)m_cost->preferenceCost(f, oldDay);
-
-            const double dAcc = m_cost->deltaAccounting2(occ, oldDay, -n, newDay, +n);
-            delta = dPref + dAcc;
-
-            bool accept = (delta < 0.0) || (uni(rng) < std::exp(-delta / std::max(1e-9, T)));
-            if (accept) {
-                removeFromDay(f, oldDay);
-                occ[oldDay] -= n;
-                current[f] = newDay;
-                occ[newDay] += n;
-                addToDay(f, newDay);
-
-                currentCost += delta;
-                if (currentCost < bestCost) {
-                    bestCost = currentCost;
-                    best = current;
-                }
+        if (m_params.oscillation) {
+            if (!state.feasible()) ++infeasibleIters;
+            if (m_params.penaltyAdaptEvery > 0 && iter % m_params.penaltyAdaptEvery == 0) {
+                const double ratio = (double)infeasibleIters / m_params.penaltyAdaptEvery;
+                const double w = state.penaltyWeight();
+                state.setPenaltyWeight(std::clamp(ratio > m_params.targetInfeasible ? w * 1.1 : w / 1.1,
+                                                  1e-3, 1e7));
+                infeasibleIters = 0;
             }
+        }
 
-        } else {
-            int f1 = famDist(rng);
-            int f2 = famDist(rng);
-            if (f1 == f2) continue;
-
-            int d1 = current[f1];
-            int d2 = current[f2];
-            if (d1 == d2) continue;
-
-            const int n1 = m_data->families()[f1].nPeople;
-            const int n2 = m_data->families()[f2].nPeople;
-
-            const int newOcc1 = occ[d1] - n1 + n2;
-            const int newOcc2 = occ[d2] - n2 + n1;
-
-            if (newOcc1 < 125 || newOcc1 > 300) continue;
-            if (newOcc2 < 125 || newOcc2 > 300) continue;
-
-            const double dPref =
-                (double)m_cost->preferenceCost(f1, d2) +
-                (double)m_cost->preferenceCost(f2, d1) -
-                (double)m_cost->preferenceCost(f1, d1) -
-                (double)m_cost->preferenceCost(f2, d2);
-
-            const double dAcc =
-                m_cost->deltaAccounting2(occ, d1, (-n1 + n2), d2, (-n2 + n1));
-
-            delta = dPref + dAcc;
-
-            bool accept = (delta < 0.0) || (uni(rng) < std::exp(-delta / std::max(1e-9, T)));
-            if (accept) {
-                removeFromDay(f1, d1);
-                removeFromDay(f2, d2);
-
-                occ[d1] = newOcc1;
-                occ[d2] = newOcc2;
-                current[f1] = d2;
-                current[f2] = d1;
-
-                addToDay(f1, d2);
-                addToDay(f2, d1);
-
-                currentCost += delta;
-                if (currentCost < bestCost) {
-                    bestCost = currentCost;
-                    best = current;
+        if (m_exchange && m_migration.everyIterations > 0 && iter % m_migration.everyIterations == 0) {
+            m_exchange->publish(m_island, best, bestCost, zobrist->hash(best));
+
+            // Migrants are re-scored here: other islands may run other builds
+            // or have died mid-campaign, so only the assignment is trusted.
+            // Only adopted migrants are remembered; a rejected one is
+            // reconsidered once the local state has become worse than it.
+            Migrant m;
+            if (importMigrant(rng, m) && !imported.contains(m.hash)) {
+                std::vector<int> mOcc;
+                const double mCost = m_cost->totalCost(m.assignment, &mOcc);
+                bool feasible = true;
+                for (int d = 1; d <= 100; ++d)
+                    if (mOcc[d] < 125 || mOcc[d] > 300) { feasible = false; break; }
+
+                if (feasible && mCost < currentCost - m_migration.minImprovement) {
+                    imported.insert(m.hash);
+                    state.reset(m.assignment);
+                    currentCost = state.cost();
+                    if (currentCost < bestCost) {
+                        bestCost = currentCost;
+                        best = state.assignment();
+                    }
+                    emit log(QString("Imported elite %1 from island %2")
+                                 .arg(mCost, 0, 'f', 2).arg(m.island));
                 }
             }
         }
 
+        // Checked every 4096 iterations; the writer only copies `best`.
+        if (m_snapshots && (iter & 4095) == 0
+            && m_snapshotPolicy.due(bestCost, snapshotCost, snapshotTimer.elapsed())) {
+            m_snapshots->submit(best, bestCost, m_snapshotPolicy.csvPath, snapshotBinary);
+            snapshotCost = bestCost;
+            snapshotTimer.restart();
+        }
+
         if (iter % m_params.reportEvery == 0) {
             QVector<int> occQt(100);
             for (int d = 1; d <= 100; ++d) occQt[d - 1] = occ[d];
@@ -293,6 +414,28 @@ void SolverWorker::run()
         }
     }
 
+    // The drift sample compares the tracked best with its exact cost before
+    // the polisher changes `best`.
+    maxDrift = std::max(maxDrift, std::abs(bestCost - m_cost->totalCost(best)));
+    if (maxDrift > AccountingTracker::kTolerance)
+        emit log(QString("Max cost drift observed: %1").arg(maxDrift, 0, 'g', 6));
+
+    if (m_params.polish && !m_stop.load()) {
+        emit log("Polishing best assignment...");
+        const PolishStats ps = Polisher(m_data, m_cost).polish(best, m_params.threads);
+        emit log(QString("Polish: %1 moves, %2 swaps in %3 rounds")
+                     .arg(ps.moves).arg(ps.swaps).arg(ps.rounds));
+        emit log(QString("Polish gain: %1").arg(ps.gain, 0, 'f', 2));
+    }
+
+    // Report the cost of `best` exactly as it will be scored.
+    bestCost = m_cost->totalCost(best);
+
+    if (m_exchange)
+        m_exchange->publish(m_island, best, bestCost, zobrist->hash(best));
+    if (m_snapshots)
+        m_snapshots->submit(best, bestCost, m_snapshotPolicy.csvPath, snapshotBinary);
+
     QVector<int> bestQt(F);
     for (int i = 0; i < F; ++i) bestQt[i] = best[i];
 
@@ -6,6 +6,19 @@
 #include <vector>
 #include "problemdata.h"
 #include "costmodel.h"
+#include "annealstate.h"
+#include "zobrist.h"
+#include "island.h"
+#include "snapshotwriter.h"
+
+// Neighbourhood mix of annealStep.
+struct MoveMix {
+    double swapProbability = 0.30;       // swap two families instead of moving one
+    double choiceMoveProbability = 0.85; // a move targets one of the family's choices, else any day
+    int choiceRanks = 10;                // choices 0..choiceRanks-1 are eligible targets
+    double shapeProbability = 0.0;       // occupancy-shaping step between days with large accounting terms
+                                         // (opt-in; at 0 no extra draw is made, so trajectories are unchanged)
+};
 
 struct SolverParams {
     int maxIterations = 200000;
@@ -13,8 +26,43 @@ struct SolverParams {
     double startTemp = 10000.0;
     double endTemp = 1.0;
     uint32_t seed = 42;
+    int auditEvery = 1000000; // recompute the exact total and resync every N iterations
+    int tabuSize = 0;         // recently visited states rejected unless improving (0 = off)
+    bool polish = true;       // steepest-descent polish of the best assignment after annealing
+    int threads = 0;          // worker threads for parallel phases (0 = all cores)
+    MoveMix moves;
+
+    // Strategic oscillation: allow 125/300 violations at an adaptive cost per
+    // person and steer the weight so roughly `targetInfeasible` of the
+    // iterations are spent outside the feasible region.
+    bool oscillation = false;
+    double penaltyWeight = 100.0;
+    double targetInfeasible = 0.3;
+    int penaltyAdaptEvery = 10000;
 };
 
+// Greedy choice-order placement followed by a repair pass that lifts every
+// day to at least 125 people.
+std::vector<int> makeFeasibleAssignment(const ProblemData* data,
+                                        const CostModel* cost,
+                                        std::mt19937& rng);
+
+// One annealing proposal (move or swap) at temperature T, accepted by the
+// Metropolis rule. With a tabu table (state must be hashing), non-improving
+// proposals that lead back to a recently visited state are rejected.
+// Returns true if the state changed.
+bool annealStep(AnnealState& state, std::mt19937& rng, double T,
+                const MoveMix& mix = MoveMix(), RecencyTable* tabu = nullptr);
+
+// Runs `iterations` annealing steps with exponential cooling from t0 to t1,
+// keeping the best assignment seen in `best` / `bestCost`. Returns early once
+// `stop` is set (checked every 1024 steps).
+void annealBurst(AnnealState& state, std::mt19937& rng,
+                 int iterations, double t0, double t1,
+                 std::vector<int>& best, double& bestCost,
+                 const MoveMix& mix = MoveMix(),
+                 const std::atomic_bool* stop = nullptr);
+
 class SolverWorker : public QObject
 {
     Q_OBJECT
@@ -24,6 +72,14 @@ public:
                  const QVector<int>& initialAssignment,
                  const SolverParams& params);
 
+    // Joins an island campaign: every `migration.everyIterations` the best
+    // assignment is published to `island`'s slot and an elite from another
+    // island may replace the current state.
+    void setMigration(IslandExchange* exchange, int island, const MigrationParams& migration);
+    // Hands the best assignment to `writer` during the run as `policy`
+    // dictates, and once more when the run ends.
+    void setSnapshots(SnapshotWriter* writer, const SnapshotPolicy& policy);
+
 public slots:
     void run();
     void stop();
@@ -40,5 +96,12 @@ private:
     SolverParams m_params;
     std::atomic_bool m_stop{false};
 
-    std::vector<int> makeFeasibleInitial(std::mt19937& rng) const;
+    IslandExchange* m_exchange = nullptr;
+    int m_island = -1;
+    MigrationParams m_migration;
+
+    SnapshotWriter* m_snapshots = nullptr;
+    SnapshotPolicy m_snapshotPolicy;
+
+    bool importMigrant(std::mt19937& rng, Migrant& out) const;
 };
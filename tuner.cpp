@@ -0,0 +1,225 @@
+#include "tuner.h"
+#include "parallel.h"
+#include "seedstream.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+
+namespace {
+
+template <typename T>
+std::pair<T, T> rangeOf(const std::vector<T>& v)
+{
+    const auto mm = std::minmax_element(v.begin(), v.end());
+    return { *mm.first, *mm.second };
+}
+
+double sampleLog(std::mt19937& rng, double lo, double hi)
+{
+    if (lo <= 0.0 || lo == hi) return std::uniform_real_distribution<double>(lo, hi)(rng);
+    return std::exp(std::uniform_real_distribution<double>(std::log(lo), std::log(hi))(rng));
+}
+
+} // namespace
+
+Tuner::Tuner(const ProblemData& data, const CostModel& cost, const SolverParams& base)
+    : m_data(data), m_cost(cost), m_base(base)
+{
+}
+
+bool Tuner::strategyFromString(const QString& s, TuneStrategy& out)
+{
+    if (s == "grid") out = TuneStrategy::Grid;
+    else if (s == "random") out = TuneStrategy::Random;
+    else if (s == "halving") out = TuneStrategy::Halving;
+    else return false;
+    return true;
+}
+
+std::vector<SolverParams> Tuner::gridConfigs(const TuneSpace& space) const
+{
+    std::vector<SolverParams> out;
+    for (double t0 : space.startTemps)
+        for (double t1 : space.endTemps)
+            for (int iters : space.iterations)
+                for (double swap : space.swapProbabilities)
+                    for (double choice : space.choiceMoveProbabilities)
+                        for (int ranks : space.choiceRanks)
+                            for (double shape : space.shapeProbabilities) {
+                                SolverParams p = m_base;
+                                p.startTemp = t0;
+                                p.endTemp = t1;
+                                p.maxIterations = iters;
+                                p.moves.swapProbability = swap;
+                                p.moves.choiceMoveProbability = choice;
+                                p.moves.choiceRanks = ranks;
+                                p.moves.shapeProbability = shape;
+                                out.push_back(p);
+                            }
+    return out;
+}
+
+std::vector<SolverParams> Tuner::randomConfigs(const TuneSpace& space, int count, uint32_t seed) const
+{
+    std::mt19937 rng(seed);
+    const auto t0 = rangeOf(space.startTemps);
+    const auto t1 = rangeOf(space.endTemps);
+    const auto iters = rangeOf(space.iterations);
+    const auto swap = rangeOf(space.swapProbabilities);
+    const auto choice = rangeOf(space.choiceMoveProbabilities);
+    const auto ranks = rangeOf(space.choiceRanks);
+    const auto shape = rangeOf(space.shapeProbabilities);
+
+    std::vector<SolverParams> out;
+    for (int i = 0; i < count; ++i) {
+        SolverParams p = m_base;
+        p.startTemp = sampleLog(rng, t0.first, t0.second);
+        p.endTemp = sampleLog(rng, t1.first, t1.second);
+        p.maxIterations = (int)std::lround(sampleLog(rng, iters.first, iters.second));
+        p.moves.swapProbability = std::uniform_real_distribution<double>(swap.first, swap.second)(rng);
+        p.moves.choiceMoveProbability = std::uniform_real_distribution<double>(choice.first, choice.second)(rng);
+        p.moves.choiceRanks = std::uniform_int_distribution<int>(ranks.first, ranks.second)(rng);
+        p.moves.shapeProbability = std::uniform_real_distribution<double>(shape.first, shape.second)(rng);
+        out.push_back(p);
+    }
+    return out;
+}
+
+TuneRun Tuner::runOne(const SolverParams& params) const
+{
+    TuneRun r;
+    r.params = params;
+
+    SolverWorker worker(&m_data, &m_cost, QVector<int>(), params);
+    QElapsedTimer timer;
+    QObject::connect(&worker, &SolverWorker::progress,
+                     [&](int iter, double, double bestCost, QVector<int>) {
+                         r.curve.push_back({ timer.nsecsElapsed() * 1e-9, iter, bestCost });
+                     });
+    QObject::connect(&worker, &SolverWorker::finished,
+                     [&](QVector<int>, double bestCost) { r.finalCost = bestCost; });
+
+    timer.start();
+    worker.run();
+    r.seconds = timer.nsecsElapsed() * 1e-9;
+    r.curve.push_back({ r.seconds, params.maxIterations, r.finalCost });
+    return r;
+}
+
+std::vector<TuneRun> Tuner::runAll(const std::vector<SolverParams>& configs, const std::vector<int>& ids,
+                                   int rung, const TuneOptions& options) const
+{
+    const int repeats = std::max(1, options.repeats);
+    std::vector<TuneRun> runs(configs.size() * (size_t)repeats);
+
+    parallelFor((int)runs.size(), options.threads, [&](int i) {
+        const int c = i / repeats;
+        const int replica = i % repeats;
+        SolverParams p = configs[c];
+        // Every configuration sees the same seeds, so differences between
+        // configurations are not drowned by seed noise.
+        p.seed = deriveSeed(options.seed, SeedStream::TuneReplica, (uint64_t)replica);
+        p.reportEvery = std::max(1, p.maxIterations / 200);
+        if (options.threads != 1) p.threads = 1;
+
+        runs[i] = runOne(p);
+        runs[i].config = ids[c];
+        runs[i].rung = rung;
+        runs[i].replica = replica;
+    });
+    return runs;
+}
+
+std::vector<TuneRun> Tuner::run(const TuneSpace& space, const TuneOptions& options) const
+{
+    if (options.strategy == TuneStrategy::Grid || options.strategy == TuneStrategy::Random) {
+        const std::vector<SolverParams> configs = options.strategy == TuneStrategy::Grid
+            ? gridConfigs(space)
+            : randomConfigs(space, options.samples, deriveSeed(options.seed, SeedStream::TuneSampling));
+        std::vector<int> ids(configs.size());
+        for (size_t i = 0; i < ids.size(); ++i) ids[i] = (int)i;
+        return runAll(configs, ids, 0, options);
+    }
+
+    // Successive halving: iterations are the budget. Rung k runs the
+    // survivors at maxIterations / eta^(rungs-1-k) and keeps the best 1/eta.
+    const int eta = std::max(2, options.eta);
+    std::vector<SolverParams> configs =
+        randomConfigs(space, options.samples, deriveSeed(options.seed, SeedStream::TuneSampling));
+    std::vector<int> ids(configs.size());
+    for (size_t i = 0; i < ids.size(); ++i) ids[i] = (int)i;
+
+    int rungs = 1;
+    for (size_t n = configs.size(); n >= (size_t)eta; n /= (size_t)eta) ++rungs;
+    const int maxIterations = rangeOf(space.iterations).second;
+
+    std::vector<TuneRun> all;
+    for (int rung = 0; rung < rungs && !configs.empty(); ++rung) {
+        const int iters = std::max(1, (int)(maxIterations / std::pow((double)eta, rungs - 1 - rung)));
+        for (SolverParams& p : configs) p.maxIterations = iters;
+
+        const std::vector<TuneRun> runs = runAll(configs, ids, rung, options);
+        all.insert(all.end(), runs.begin(), runs.end());
+
+        const std::vector<TuneSummary> ranked = summarize(runs);
+        const size_t keep = std::max<size_t>(1, (configs.size() + (size_t)eta - 1) / (size_t)eta);
+        std::vector<SolverParams> nextConfigs;
+        std::vector<int> nextIds;
+        for (size_t i = 0; i < ranked.size() && i < keep; ++i) {
+            nextConfigs.push_back(ranked[i].params);
+            nextIds.push_back(ranked[i].config);
+        }
+        configs.swap(nextConfigs);
+        ids.swap(nextIds);
+    }
+    return all;
+}
+
+std::vector<TuneSummary> Tuner::summarize(const std::vector<TuneRun>& runs)
+{
+    std::map<std::pair<int, int>, std::vector<const TuneRun*>> groups;
+    for (const TuneRun& r : runs) groups[{ r.config, r.rung }].push_back(&r);
+
+    std::vector<TuneSummary> out;
+    for (const auto& g : groups) {
+        TuneSummary s;
+        s.config = g.first.first;
+        s.rung = g.first.second;
+        s.params = g.second.front()->params;
+        s.bestCost = g.second.front()->finalCost;
+        for (const TuneRun* r : g.second) {
+            s.meanCost += r->finalCost;
+            s.meanSeconds += r->seconds;
+            s.bestCost = std::min(s.bestCost, r->finalCost);
+        }
+        s.meanCost /= (double)g.second.size();
+        s.meanSeconds /= (double)g.second.size();
+        out.push_back(s);
+    }
+
+    for (TuneSummary& s : out) {
+        s.pareto = true;
+        for (const TuneSummary& o : out) {
+            if (o.meanSeconds <= s.meanSeconds && o.meanCost <= s.meanCost
+                && (o.meanSeconds < s.meanSeconds || o.meanCost < s.meanCost)) {
+                s.pareto = false;
+                break;
+            }
+        }
+    }
+
+    std::stable_sort(out.begin(), out.end(), [](const TuneSummary& a, const TuneSummary& b) {
+        return a.meanCost < b.meanCost;
+    });
+    return out;
+}
+
+std::vector<TuneSummary> Tuner::bestWithin(const std::vector<TuneSummary>& summaries, double seconds)
+{
+    std::vector<TuneSummary> out;
+    for (const TuneSummary& s : summaries)
+        if (s.pareto && s.meanSeconds <= seconds) out.push_back(s);
+    return out;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "problemdata.h"
+#include "costmodel.h"
+#include "solver.h"
+#include <QString>
+#include <vector>
+
+enum class TuneStrategy {
+    Grid,     // every combination of the listed values
+    Random,   // `samples` draws from the ranges spanned by the listed values
+    Halving,  // successive halving on iterations over `samples` random draws
+};
+
+// Candidate values per knob. A single value fixes the knob; for Random and
+// Halving the min/max of the list bound the sampled range.
+struct TuneSpace {
+    std::vector<double> startTemps{ 10000.0 };
+    std::vector<double> endTemps{ 1.0 };
+    std::vector<int> iterations{ 2000000 };
+    std::vector<double> swapProbabilities{ 0.30 };
+    std::vector<double> choiceMoveProbabilities{ 0.85 };
+    std::vector<int> choiceRanks{ 10 };
+    std::vector<double> shapeProbabilities{ 0.0 };
+};
+
+struct TuneOptions {
+    TuneStrategy strategy = TuneStrategy::Grid;
+    int samples = 32;        // configurations drawn by Random / Halving
+    int eta = 3;             // Halving keeps 1/eta per rung and multiplies iterations by eta
+    int repeats = 1;         // seeds per configuration
+    int threads = 0;         // concurrent runs (0 = all cores)
+    uint32_t seed = 42;      // master seed of the sampling and replica seed streams
+};
+
+struct TunePoint {
+    double seconds = 0.0;
+    int iteration = 0;
+    double bestCost = 0.0;
+};
+
+// One solver run of a configuration.
+struct TuneRun {
+    int config = 0;
+    int rung = 0;            // Halving rung, 0 otherwise
+    int replica = 0;
+    SolverParams params;
+    std::vector<TunePoint> curve;
+    double finalCost = 0.0;
+    double seconds = 0.0;
+};
+
+// Replicas of one configuration at one rung, averaged.
+struct TuneSummary {
+    int config = 0;
+    int rung = 0;
+    SolverParams params;
+    double meanCost = 0.0;
+    double bestCost = 0.0;
+    double meanSeconds = 0.0;
+    bool pareto = false;     // no other summary is both faster and cheaper
+};
+
+// Runs SolverWorker over a search space on a pool of threads and records the
+// best-cost-vs-time curve of every run.
+class Tuner {
+public:
+    // `base` supplies everything the search space does not cover.
+    Tuner(const ProblemData& data, const CostModel& cost, const SolverParams& base);
+
+    std::vector<TuneRun> run(const TuneSpace& space, const TuneOptions& options) const;
+
+    // Groups runs by (config, rung), sorted by mean cost, with the
+    // cost/time Pareto front flagged.
+    static std::vector<TuneSummary> summarize(const std::vector<TuneRun>& runs);
+    // Pareto summaries finishing within `seconds`, cheapest first.
+    static std::vector<TuneSummary> bestWithin(const std::vector<TuneSummary>& summaries, double seconds);
+
+    static bool strategyFromString(const QString& s, TuneStrategy& out);
+
+private:
+    const ProblemData& m_data;
+    const CostModel& m_cost;
+    SolverParams m_base;
+
+    std::vector<SolverParams> gridConfigs(const TuneSpace& space) const;
+    std::vector<SolverParams> randomConfigs(const TuneSpace& space, int count, uint32_t seed) const;
+    std::vector<TuneRun> runAll(const std::vector<SolverParams>& configs, const std::vector<int>& ids,
+                                int rung, const TuneOptions& options) const;
+    TuneRun runOne(const SolverParams& params) const;
+};
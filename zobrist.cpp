@@ -0,0 +1,27 @@
+#include "zobrist.h"
+#include <random>
+
+ZobristTable::ZobristTable(int families, uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    m_keys.resize((size_t)families * 100u);
+    for (auto& k : m_keys) k = rng();
+}
+
+uint64_t ZobristTable::hash(const std::vector<int>& assignment) const
+{
+    uint64_t h = 0;
+    for (size_t i = 0; i < assignment.size(); ++i)
+        h ^= key((int)i, assignment[i]);
+    return h;
+}
+
+RecencyTable::RecencyTable(int capacity)
+{
+    // At least two slots, so ~i and i differ in the bits the mask keeps.
+    size_t size = 2;
+    while (size < (size_t)capacity) size <<= 1;
+    m_slots.resize(size);
+    for (size_t i = 0; i < size; ++i) m_slots[i] = ~(uint64_t)i;
+    m_mask = size - 1;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Random 64-bit key per (family, day). The hash of an assignment is the XOR
+// of its keys, so moving family f from day a to day b updates it in O(1):
+// h ^= key(f, a) ^ key(f, b). The default seed is fixed so hashes can be
+// compared across runs and processes.
+class ZobristTable {
+public:
+    static constexpr uint64_t kDefaultSeed = 0x5A17A2019ull;
+
+    explicit ZobristTable(int families, uint64_t seed = kDefaultSeed);
+
+    uint64_t key(int familyIndex, int day) const
+    {
+        return m_keys[(size_t)familyIndex * 100u + (size_t)(day - 1)];
+    }
+    uint64_t hash(const std::vector<int>& assignment) const;
+
+private:
+    std::vector<uint64_t> m_keys;
+};
+
+// Bounded memory of recently visited state hashes. Direct-mapped: a new hash
+// evicts whatever occupied its slot, so old states are forgotten as the
+// table fills and lookups stay O(1). An empty slot i holds ~i, which never
+// maps to slot i, so no hash (0 included) is seen before it is inserted.
+class RecencyTable {
+public:
+    explicit RecencyTable(int capacity);
+
+    bool contains(uint64_t hash) const { return m_slots[hash & m_mask] == hash; }
+    void insert(uint64_t hash) { m_slots[hash & m_mask] = hash; }
+
+private:
+    std::vector<uint64_t> m_slots;
+    uint64_t m_mask = 0;
+};